@@ -3,6 +3,7 @@ QT += widgets
 # Make sure we do not accidentally #include files placed in 'res'
 CONFIG += no_include_pwd
 CONFIG += console
+CONFIG += thread
 CONFIG -= app_bundle
 
 SOURCES += $$PWD/src/*.cpp
@@ -17,6 +18,12 @@ QMAKE_CXXFLAGS += -std=c++11 \
     -Werror=return-type \
     -Wunreachable-code \
 
+# Per-iteration phase timers in ForceDirected, see src/Telemetry.h
+# DEFINES += GRAPHVIZ_TELEMETRY
+
+# Counting operator new for --check-allocations, see src/Allocations.h
+# DEFINES += GRAPHVIZ_COUNT_ALLOCATIONS
+
 # Copies the given files to the destination directory
 # The rest of this file defines how to copy the resources folder
 defineTest(copyToDestdir) {
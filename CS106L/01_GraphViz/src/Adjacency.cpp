@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "Adjacency.h"
+
+using std::uint32_t;
+using std::vector;
+
+// Count the degrees into offsets[i + 1] and sum them up, so that offsets[i]
+// is where the list of node i starts. Filling the lists advances offsets[i]
+// to where the list ends, which is where the next one starts; shifting the
+// offsets up by one then restores them without a second array.
+void BuildAdjacency(std::size_t numNodes, const vector<Edge> &edges, Adjacency &adjacency) {
+    if (numNodes >= std::numeric_limits<uint32_t>::max() ||
+        edges.size() >= std::numeric_limits<uint32_t>::max() / 2)
+        throw std::length_error("The graph is too large for 32-bit indices!");
+
+    vector<uint32_t> &offsets = adjacency.offsets;
+    offsets.assign(numNodes + 1, 0);
+    for (std::size_t i = 0; i < edges.size(); ++i) {
+        if (edges[i].start == edges[i].end) continue;
+        ++offsets[edges[i].start + 1];
+        ++offsets[edges[i].end + 1];
+    }
+    for (std::size_t i = 0; i < numNodes; ++i)
+        offsets[i + 1] += offsets[i];
+
+    adjacency.neighbors.resize(offsets[numNodes]);
+    for (std::size_t i = 0; i < edges.size(); ++i) {
+        uint32_t start = edges[i].start, end = edges[i].end;
+        if (start == end) continue;
+        adjacency.neighbors[offsets[start]++] = end;
+        adjacency.neighbors[offsets[end]++] = start;
+    }
+    for (std::size_t i = numNodes; i > 0; --i)
+        offsets[i] = offsets[i - 1];
+    offsets[0] = 0;
+}
+
+// Cuthill-McKee numbering of every component, reversed at the end. Ties in
+// degree go to the lower index, so plain std::sort gives the same order on
+// every platform without the buffer std::stable_sort allocates.
+void ReverseCuthillMcKee(const Adjacency &adjacency, vector<uint32_t> &order,
+                         vector<uint32_t> &scratch) {
+    std::size_t n = adjacency.numNodes();
+    auto byDegreeThenIndex = [&](uint32_t a, uint32_t b) {
+        uint32_t da = adjacency.degree(a), db = adjacency.degree(b);
+        return da < db || (da == db && a < b);
+    };
+
+    // scratch holds the nodes by degree, then a visited flag for every node
+    scratch.assign(2 * n, 0);
+    uint32_t *byDegree = scratch.data(), *visited = scratch.data() + n;
+    for (std::size_t i = 0; i < n; ++i)
+        byDegree[i] = i;
+    std::sort(byDegree, byDegree + n, byDegreeThenIndex);
+
+    // order doubles as the breadth-first queue: the children of every node
+    // are appended at tail, then sorted where they are
+    order.resize(n);
+    std::size_t tail = 0;
+    for (std::size_t s = 0; s < n; ++s) {
+        if (visited[byDegree[s]]) continue;
+
+        std::size_t head = tail;
+        order[tail++] = byDegree[s];
+        visited[byDegree[s]] = 1;
+        for (; head < tail; ++head) {
+            uint32_t u = order[head];
+            std::size_t first = tail;
+            for (uint32_t k = adjacency.offsets[u]; k < adjacency.offsets[u + 1]; ++k) {
+                uint32_t v = adjacency.neighbors[k];
+                if (visited[v]) continue;
+                visited[v] = 1;
+                order[tail++] = v;
+            }
+            std::sort(order.begin() + first, order.begin() + tail, byDegreeThenIndex);
+        }
+    }
+
+    std::reverse(order.begin(), order.end());
+}
+
+// Copy the neighbor lists in the new node order, renaming every neighbor
+void PermuteAdjacency(const Adjacency &adjacency, const vector<uint32_t> &order,
+                      Adjacency &permuted, vector<uint32_t> &scratch) {
+    std::size_t n = adjacency.numNodes();
+    vector<uint32_t> &position = scratch;
+    position.resize(n);
+    for (std::size_t k = 0; k < n; ++k)
+        position[order[k]] = k;
+
+    permuted.offsets.resize(n + 1);
+    permuted.neighbors.resize(adjacency.neighbors.size());
+    permuted.offsets[0] = 0;
+    for (std::size_t k = 0; k < n; ++k) {
+        uint32_t u = order[k];
+        uint32_t out = permuted.offsets[k];
+        for (uint32_t j = adjacency.offsets[u]; j < adjacency.offsets[u + 1]; ++j)
+            permuted.neighbors[out++] = position[adjacency.neighbors[j]];
+        permuted.offsets[k + 1] = out;
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+/*************************************************************************
+ * File: Adjacency.h
+ *
+ * A compact adjacency structure for the layout, in compressed sparse row
+ * (CSR) form: the neighbors of every node stored back to back in one
+ * array, with 32-bit indices. Every edge appears once in the neighbor list
+ * of each endpoint, so the structure takes 8 bytes per edge where a
+ * std::vector<Edge> takes 16, and the edges of a node are contiguous.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "SimpleGraph.h"
+
+/**
+ * Type: Adjacency
+ * -----------------------------------------------------------------------
+ * The neighbors of node i are neighbors[offsets[i]] up to, but excluding,
+ * neighbors[offsets[i + 1]]. offsets has one entry more than there are
+ * nodes.
+ */
+struct Adjacency {
+    std::vector<std::uint32_t> offsets;
+    std::vector<std::uint32_t> neighbors;
+
+    std::size_t numNodes() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    std::uint32_t degree(std::size_t i) const { return offsets[i + 1] - offsets[i]; }
+};
+
+/**
+ * Function: BuildAdjacency(numNodes, edges, adjacency)
+ * -----------------------------------------------------------------------
+ * Builds the adjacency of a graph with numNodes nodes from its edge list,
+ * dropping self-loops. Duplicate edges are kept. Throws length_error if the
+ * graph is too large for 32-bit indices.
+ */
+void BuildAdjacency(std::size_t numNodes, const std::vector<Edge>& edges, Adjacency& adjacency);
+
+/**
+ * Function: ReverseCuthillMcKee(adjacency, order, scratch)
+ * -----------------------------------------------------------------------
+ * Fills order with a reordering of the nodes that keeps neighbors close
+ * together: the node placed at position k is order[k]. Every connected
+ * component is numbered by a breadth-first search from a node of lowest
+ * degree, visiting neighbors in order of increasing degree, then of
+ * index, and the result is reversed. scratch is working space; passing
+ * the same vectors again saves their allocation.
+ */
+void ReverseCuthillMcKee(const Adjacency& adjacency, std::vector<std::uint32_t>& order,
+                         std::vector<std::uint32_t>& scratch);
+
+/**
+ * Function: PermuteAdjacency(adjacency, order, permuted, scratch)
+ * -----------------------------------------------------------------------
+ * Renumbers the nodes so that node order[k] becomes node k. scratch is
+ * working space, as for ReverseCuthillMcKee().
+ */
+void PermuteAdjacency(const Adjacency& adjacency, const std::vector<std::uint32_t>& order,
+                      Adjacency& permuted, std::vector<std::uint32_t>& scratch);
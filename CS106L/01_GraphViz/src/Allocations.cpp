@@ -0,0 +1,31 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "Allocations.h"
+
+using std::size_t;
+
+#ifdef GRAPHVIZ_COUNT_ALLOCATIONS
+static std::atomic<size_t> allocations(0);
+
+// Every other form of new, array and nothrow ones included, ends up here
+void *operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *block = std::malloc(size > 0 ? size : 1))
+        return block;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *block) noexcept {
+    std::free(block);
+}
+#endif
+
+size_t AllocationCount() {
+#ifdef GRAPHVIZ_COUNT_ALLOCATIONS
+    return allocations.load(std::memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
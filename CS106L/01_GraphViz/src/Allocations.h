@@ -0,0 +1,26 @@
+#pragma once
+
+/*************************************************************************
+ * File: Allocations.h
+ *
+ * Counting of heap allocations, to check that the iterations of the force
+ * layout make none. In builds with GRAPHVIZ_COUNT_ALLOCATIONS defined
+ * (uncomment the DEFINES line in GraphViz.pro) the global operator new
+ * counts every call; other builds keep the standard one and count nothing.
+ */
+
+#include <cstddef>
+
+#ifdef GRAPHVIZ_COUNT_ALLOCATIONS
+const bool kAllocationCountEnabled = true;
+#else
+const bool kAllocationCountEnabled = false;
+#endif
+
+/**
+ * Function: AllocationCount()
+ * -----------------------------------------------------------------------
+ * Returns the number of calls to operator new so far, on all threads, or
+ * 0 in builds that do not count them.
+ */
+std::size_t AllocationCount();
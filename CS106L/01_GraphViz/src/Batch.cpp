@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+
+#include "Batch.h"
+#include "GraphIO.h"
+#include "ThreadPool.h"
+
+using std::cout;	using std::endl;
+using std::size_t;
+using std::vector;
+
+// Settings of a batch run unless given on the command line: those of
+// --headless, with the approximations of the interactive program for large
+// graphs
+const double kBatchTheta = 0.8;
+const size_t kBatchMultilevelMinNodes = 1000;
+
+// One job per line, the layout file defaulting to the graph file's name
+bool ReadManifest(const std::string &path, vector<BatchJob> &jobs) {
+    std::ifstream input(path.c_str());
+    if (!input.is_open()) return false;
+    std::string line;
+    while (std::getline(input, line)) {
+        std::istringstream fields(line);
+        BatchJob job;
+        if (!(fields >> job.graphFile) || job.graphFile[0] == '#') continue;
+        if (!(fields >> job.layoutFile))
+            job.layoutFile = job.graphFile + ".layout";
+        jobs.push_back(job);
+    }
+    return true;
+}
+
+// Lay out the graph in the given state and write its layout
+static void LayOutJob(const BatchJob &job, SimpleGraph &graph, const LayoutOptions &options,
+                      const ComponentOptions &components, LayoutState &state,
+                      BatchResult &result) {
+    result.stats = ComponentLayout(graph, options, components, state);
+    std::ofstream output(job.layoutFile.c_str());
+    WriteLayout(graph, output);
+    result.ok = bool(output);
+}
+
+// Small graphs first, on one thread each, then the large ones they passed
+// over, on all of them. Finding a graph large costs one extra load, which
+// is small next to laying it out.
+size_t BatchLayout(const vector<BatchJob> &jobs, const LayoutOptions &options,
+                   const ComponentOptions &components,
+                   const std::function<void(size_t, const BatchResult&)> &done) {
+    LayoutOptions smallOptions = options;
+    smallOptions.draw = false;
+    smallOptions.threads = 1;
+    smallOptions.telemetry = nullptr;
+
+    std::mutex mutex;
+    size_t failed = 0;
+    vector<size_t> large;
+    auto finish = [&](size_t j, const BatchResult &result) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!result.ok) ++failed;
+        done(j, result);
+    };
+
+    // Every thread keeps its graph and layout state from one job to the next
+    ThreadPool pool(options.threads);
+    vector<SimpleGraph> scratch(pool.size());
+    vector<LayoutState> states(pool.size());
+    pool.runTasks(jobs.size(), [&](size_t j, size_t t) {
+        SimpleGraph &graph = scratch[t];
+        BatchResult result;
+        if (LoadGraph(graph, jobs[j].graphFile)) {
+            if (graph.nodes.size() >= components.sharedPoolMinNodes) {
+                std::lock_guard<std::mutex> lock(mutex);
+                large.push_back(j);
+                return;
+            }
+            result.nodes = graph.nodes.size();
+            result.edges = graph.edges.size();
+            result.threads = 1;
+            LayOutJob(jobs[j], graph, smallOptions, components, states[t], result);
+        }
+        finish(j, result);
+    });
+    vector<SimpleGraph>().swap(scratch);
+
+    // The large graphs take turns in the first thread's state
+    LayoutOptions largeOptions = options;
+    largeOptions.draw = false;
+    for (size_t k = 0; k < large.size(); ++k) {
+        SimpleGraph graph;
+        BatchResult result;
+        if (LoadGraph(graph, jobs[large[k]].graphFile)) {
+            result.nodes = graph.nodes.size();
+            result.edges = graph.edges.size();
+            result.threads = pool.size();
+            LayOutJob(jobs[large[k]], graph, largeOptions, components, states[0], result);
+        }
+        finish(large[k], result);
+    }
+    return failed;
+}
+
+// Parse the flags, then lay out the manifest, printing every graph as it is
+// done
+int RunBatch(int argc, char **argv) {
+    LayoutOptions options;
+    options.theta = kBatchTheta;
+    options.draw = false;
+    ComponentOptions components;
+    components.multilevelMinNodes = kBatchMultilevelMinNodes;
+    bool usage = argc < 3 || argc % 2 != 1;
+    for (int i = 3; !usage && i + 1 < argc; i += 2) {
+        std::string flag = argv[i], value = argv[i + 1];
+        if (flag == "--threads") options.threads = std::atoi(value.c_str());
+        else if (flag == "--seconds") options.seconds = std::atof(value.c_str());
+        else if (flag == "--iterations") options.iterations = std::atoi(value.c_str());
+        else if (flag == "--tolerance") options.tolerance = std::atof(value.c_str());
+        else if (flag == "--placement") components.placement = FindPlacement(value);
+        else if (flag == "--seed") components.seed = std::strtoul(value.c_str(), NULL, 10);
+        else if (flag == "--engine" && value == "force") components.stress = false;
+        else if (flag == "--engine" && value == "stress") components.stress = true;
+        else usage = true;
+    }
+    if (usage || components.placement == NULL ||
+        (options.iterations <= 0 && options.tolerance <= 0 && options.seconds <= 0)) {
+        std::cerr << "Usage: " << argv[0] << " --batch <manifest> [--threads K] [--seconds S]"
+                  << " [--iterations N] [--tolerance T] [--placement NAME] [--seed S]"
+                  << " [--engine force|stress]" << endl;
+        return 1;
+    }
+
+    vector<BatchJob> jobs;
+    if (!ReadManifest(argv[2], jobs)) {
+        std::cerr << "Sorry, I can't read the manifest " << argv[2] << endl;
+        return 1;
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+    cout << "graph,nodes,edges,threads,iterations,seconds,converged" << endl;
+    size_t failed = BatchLayout(jobs, options, components, [&](size_t j, const BatchResult &result) {
+        if (!result.ok) {
+            std::cerr << "Sorry, I can't lay out " << jobs[j].graphFile << " into "
+                      << jobs[j].layoutFile << endl;
+            return;
+        }
+        cout << jobs[j].graphFile << "," << result.nodes << "," << result.edges << ","
+             << result.threads << "," << result.stats.iterations << ","
+             << result.stats.seconds << "," << (result.stats.converged ? 1 : 0) << endl;
+    });
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+
+    std::cerr << jobs.size() - failed << " graphs laid out in " << elapsed.count() << " s ("
+              << (jobs.size() - failed) / std::max(elapsed.count(), 1e-9) << " graphs/s)";
+    if (failed > 0) std::cerr << ", " << failed << " failed";
+    std::cerr << endl;
+    return failed > 0 ? 1 : 0;
+}
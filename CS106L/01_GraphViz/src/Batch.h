@@ -0,0 +1,84 @@
+#pragma once
+
+/*************************************************************************
+ * File: Batch.h
+ *
+ * Layout of many graphs in one process, without a window. Most graphs in
+ * a batch are small, so the work is spread by graph rather than within
+ * one: every thread lays out whole graphs, and only the large ones get the
+ * threads of the whole pool.
+ */
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Components.h"
+#include "Layout.h"
+
+/**
+ * Type: BatchJob
+ * -----------------------------------------------------------------------
+ * One graph of a batch: the file to read it from and the file to write
+ * its layout to, in the format of WriteLayout() (see GraphIO.h).
+ */
+struct BatchJob {
+    std::string graphFile;
+    std::string layoutFile;
+};
+
+/**
+ * Type: BatchResult
+ * -----------------------------------------------------------------------
+ * What became of one job: its size, the stats of its layout, how many
+ * threads laid it out, and whether the graph was read and its layout
+ * written.
+ */
+struct BatchResult {
+    std::size_t nodes = 0;
+    std::size_t edges = 0;
+    std::size_t threads = 0;
+    LayoutStats stats;
+    bool ok = false;
+};
+
+/**
+ * Function: ReadManifest(const std::string& path, std::vector<BatchJob>& jobs)
+ * -----------------------------------------------------------------------
+ * Reads a manifest with one job per line: a graph file, then optionally
+ * the layout file, which defaults to the graph file with ".layout"
+ * appended. Blank lines and lines starting with '#' are skipped. Returns
+ * false if the manifest can't be read.
+ */
+bool ReadManifest(const std::string& path, std::vector<BatchJob>& jobs);
+
+/**
+ * Function: BatchLayout(jobs, options, components, done)
+ * -----------------------------------------------------------------------
+ * Lays out every graph of the batch with ComponentLayout() (see
+ * Components.h) and writes its layout. Graphs with fewer than
+ * components.sharedPoolMinNodes nodes run side by side, one per thread of
+ * a pool of options.threads threads, handed out by the work-stealing
+ * ThreadPool::runTasks(); every thread reuses one graph for all the jobs
+ * it runs. The larger graphs follow one after another, each with all the
+ * threads. done(job, result) is called for every job as soon as it is
+ * finished, one call at a time, from the thread that ran it. Returns the
+ * number of jobs that failed.
+ */
+std::size_t BatchLayout(const std::vector<BatchJob>& jobs, const LayoutOptions& options,
+                        const ComponentOptions& components,
+                        const std::function<void(std::size_t, const BatchResult&)>& done);
+
+/**
+ * Function: RunBatch(int argc, char** argv)
+ * -----------------------------------------------------------------------
+ * Handles "--batch <manifest> [--threads K] [--seconds S] [--iterations N]
+ * [--tolerance T] [--placement NAME] [--seed S] [--engine force|stress]".
+ * Lays out every job in the manifest with BatchLayout() and streams one
+ * CSV line per graph to standard output as it finishes, in the order they
+ * finish, then prints the number of graphs per second to standard error.
+ * Graphs that can't be read or written are reported and skipped. Returns
+ * the exit code of the program.
+ */
+int RunBatch(int argc, char** argv);
@@ -0,0 +1,489 @@
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "Benchmark.h"
+#include "Allocations.h"
+#include "Components.h"
+#include "Generators.h"
+#include "GraphIO.h"
+#include "Incremental.h"
+#include "Layout.h"
+#include "Multilevel.h"
+#include "Placement.h"
+#include "Stress.h"
+
+using std::cout;	using std::endl;
+using std::vector;
+
+// Settings of the Barnes-Hut and cutoff runs
+const double kBenchmarkTheta = 0.8;
+const double kBenchmarkCutoff = 3.0;
+
+// Graphs larger than this skip the all-pairs run, which would take minutes
+const size_t kMaxAllPairsNodes = 40000;
+
+// Iteration limit of the placement runs, so that a placement that never
+// settles does not stall the benchmark
+const int kPlacementMaxIterations = 20000;
+
+// Iteration limits of the time-to-quality runs: the first, and the last for
+// each engine
+const int kQualityFirstIterations = 4;
+const int kQualityMaxForceIterations = 32768;
+const int kQualityMaxStressIterations = 1024;
+
+// Graphs of the suite run without arguments, the bundled ones and then the
+// generated ones, and the settings they are laid out with, those of a
+// default --headless run
+const char *const kSuiteGraphs[] = {
+    "2line", "triangle", "bull", "star", "5clique", "5grid", "3grid", "cube",
+    "octahedron", "8wheel", "10clique", "10grid", "10line", "petersen",
+    "moser-spindle", "tietze", "heawood", "icosahedron", "mobius-kantor",
+    "tesseract", "durer", "desargues", "dodecahedron", "doodad-1", "doodad-2",
+    "doodad-3", "30clique", "30cycle", "31binary-tree", "32wheel", "50line",
+    "60cycle", "63binary-tree", "64wheel", "127binary-tree",
+    "rgg:1000", "er:1000", "grid:1000", "ba:1000",
+    "rgg:10000", "er:10000", "grid:10000", "ba:10000",
+    "rgg:100000", "er:100000", "grid:100000", "ba:100000",
+};
+const int kSuiteSeconds = 60;
+const size_t kSuiteApproximateMinNodes = 1000;
+const size_t kSuiteMultilevelMinNodes = 1000;
+
+// Graphs of the allocation check run without arguments: one where the tree
+// and the grid see an even spread, and one with clusters and gaps
+const char *const kCheckGraphs[] = {"grid:2500", "rgg:2000"};
+const int kCheckIterations = 20;
+
+// Rounds of random edits of the incremental check, and its graph
+const int kEditRounds = 50;
+const char *const kEditGraph = "grid:400";
+
+// Tiles side x side copies of the graph on a grid, joining the first nodes
+// of horizontally and vertically neighboring copies, so that the result is
+// connected whenever the graph is
+static void ScaleGraph(const SimpleGraph &graph, size_t side, SimpleGraph &scaled) {
+    size_t n = graph.nodes.size();
+    scaled.nodes.clear();
+    scaled.edges.clear();
+    for (size_t row = 0; row < side; ++row) {
+        for (size_t col = 0; col < side; ++col) {
+            size_t base = (row * side + col) * n;
+            scaled.nodes.insert(scaled.nodes.end(), graph.nodes.begin(), graph.nodes.end());
+            for (size_t i = 0; i < graph.edges.size(); ++i) {
+                Edge edge = {base + graph.edges[i].start, base + graph.edges[i].end};
+                scaled.edges.push_back(edge);
+            }
+            if (n == 0) continue;
+            if (col + 1 < side) {
+                Edge edge = {base, base + n};
+                scaled.edges.push_back(edge);
+            }
+            if (row + 1 < side) {
+                Edge edge = {base, base + side * n};
+                scaled.edges.push_back(edge);
+            }
+        }
+    }
+}
+
+// Milliseconds per iteration of the layout from the given positions
+static double TimeIterations(const SimpleGraph &start, LayoutOptions options) {
+    SimpleGraph graph(start);
+    LayoutStats stats = ForceDirected(graph, options);
+    return 1000 * stats.seconds / stats.iterations;
+}
+
+// Parse the flags, then time every mode on every scaled graph
+int RunCutoffBenchmark(int argc, char **argv) {
+    size_t maxCopies = 64;
+    int iterations = 20;
+    int first = 2;
+    for (; first + 1 < argc && argv[first][0] == '-'; first += 2) {
+        std::string flag = argv[first];
+        if (flag == "--copies") maxCopies = std::strtoul(argv[first + 1], NULL, 10);
+        else if (flag == "--iterations") iterations = std::atoi(argv[first + 1]);
+        else break;
+    }
+    if (first >= argc || iterations <= 0 || argv[first][0] == '-') {
+        std::cerr << "Usage: " << argv[0] << " --benchmark [--copies N] [--iterations N] <graph-file>..." << endl;
+        return 1;
+    }
+
+    cout << "graph,copies,nodes,edges,mode,ms_per_iteration,speedup" << endl;
+    for (int f = first; f < argc; ++f) {
+        SimpleGraph graph;
+        if (!LoadGraph(graph, argv[f])) {
+            std::cerr << "Sorry, I can't read the graph in " << argv[f] << endl;
+            return 1;
+        }
+
+        for (size_t side = 1; side * side <= maxCopies; side *= 2) {
+            SimpleGraph scaled;
+            ScaleGraph(graph, side, scaled);
+
+            // Time the modes on an untangled layout, where the nodes are
+            // spread the way they are for most of a run
+            LayoutOptions options;
+            options.seconds = 0;
+            options.draw = false;
+            options.theta = kBenchmarkTheta;
+            MultilevelLayout(scaled, options);
+
+            options.iterations = iterations;
+            options.tolerance = 0;
+            LayoutOptions allPairs = options, barnesHut = options, cutoff = options;
+            allPairs.theta = 0;
+            cutoff.cutoff = kBenchmarkCutoff;
+
+            double base = 0;
+            if (scaled.nodes.size() <= kMaxAllPairsNodes)
+                base = TimeIterations(scaled, allPairs);
+            const char *modes[] = {"all-pairs", "barnes-hut", "cutoff"};
+            double times[] = {base, TimeIterations(scaled, barnesHut), TimeIterations(scaled, cutoff)};
+            for (int m = 0; m < 3; ++m) {
+                if (times[m] == 0) continue;
+                cout << argv[f] << "," << side * side << "," << scaled.nodes.size() << ","
+                     << scaled.edges.size() << "," << modes[m] << "," << times[m] << ",";
+                if (base > 0) cout << base / times[m];
+                cout << endl;
+            }
+        }
+    }
+    return 0;
+}
+
+// Parse the flags, then lay out every graph from every placement
+int RunPlacementBenchmark(int argc, char **argv) {
+    unsigned seed = 0;
+    int first = 2;
+    if (first + 1 < argc && std::string(argv[first]) == "--seed") {
+        seed = std::strtoul(argv[first + 1], NULL, 10);
+        first += 2;
+    }
+    if (first >= argc || argv[first][0] == '-') {
+        std::cerr << "Usage: " << argv[0] << " --benchmark-placement [--seed S] <graph-file>..." << endl;
+        return 1;
+    }
+
+    const char *names[] = {"circle", "random", "bfs", "spectral"};
+    cout << "graph,nodes,edges,placement,iterations,seconds,converged" << endl;
+    for (int f = first; f < argc; ++f) {
+        SimpleGraph graph;
+        if (!LoadGraph(graph, argv[f])) {
+            std::cerr << "Sorry, I can't read the graph in " << argv[f] << endl;
+            return 1;
+        }
+
+        for (int p = 0; p < 4; ++p) {
+            SimpleGraph placed(graph);
+            FindPlacement(names[p])(placed, seed);
+
+            LayoutOptions options;
+            options.seconds = 0;
+            options.iterations = kPlacementMaxIterations;
+            options.draw = false;
+            LayoutStats stats = ForceDirected(placed, options);
+            cout << argv[f] << "," << graph.nodes.size() << "," << graph.edges.size() << ","
+                 << names[p] << "," << stats.iterations << "," << stats.seconds << ","
+                 << (stats.converged ? 1 : 0) << endl;
+        }
+    }
+    return 0;
+}
+
+// Parse the flags, then run both engines under growing iteration limits
+int RunStressBenchmark(int argc, char **argv) {
+    PlacementStrategy placement = PlaceByBfsLayers;
+    int first = 2;
+    if (first + 1 < argc && std::string(argv[first]) == "--placement") {
+        placement = FindPlacement(argv[first + 1]);
+        first += 2;
+    }
+    if (placement == NULL || first >= argc || argv[first][0] == '-') {
+        std::cerr << "Usage: " << argv[0] << " --benchmark-stress [--placement NAME] <graph-file>..." << endl;
+        return 1;
+    }
+
+    cout << "graph,nodes,edges,engine,iterations,seconds,converged,normalized_stress" << endl;
+    for (int f = first; f < argc; ++f) {
+        SimpleGraph graph;
+        if (!LoadGraph(graph, argv[f])) {
+            std::cerr << "Sorry, I can't read the graph in " << argv[f] << endl;
+            return 1;
+        }
+        placement(graph, 0);
+
+        for (int engine = 0; engine < 2; ++engine) {
+            int maxIterations = engine == 0 ? kQualityMaxForceIterations : kQualityMaxStressIterations;
+            for (int limit = kQualityFirstIterations; limit <= maxIterations; limit *= 2) {
+                SimpleGraph laidOut(graph);
+                LayoutOptions options;
+                options.seconds = 0;
+                options.iterations = limit;
+                options.draw = false;
+                LayoutStats stats = engine == 0 ? ForceDirected(laidOut, options)
+                                                : StressLayout(laidOut, options);
+                cout << argv[f] << "," << graph.nodes.size() << "," << graph.edges.size() << ","
+                     << (engine == 0 ? "force" : "stress") << "," << stats.iterations << ","
+                     << stats.seconds << "," << (stats.converged ? 1 : 0) << ","
+                     << NormalizedStress(laidOut) << endl;
+                if (stats.converged) break;
+            }
+        }
+    }
+    return 0;
+}
+
+// Load or generate one graph of the suite, lay it out and print its line.
+// Returns false if there is no such graph.
+static bool RunSuiteGraph(const std::string &name, const LayoutOptions &base,
+                          const ComponentOptions &components) {
+    SimpleGraph graph;
+    if (!GenerateGraph(name, components.seed, graph) && !LoadGraph(graph, name)) {
+        std::cerr << "Sorry, I can't read or generate the graph " << name << endl;
+        return false;
+    }
+
+    LayoutOptions options = base;
+    if (graph.nodes.size() >= kSuiteApproximateMinNodes)
+        options.theta = kBenchmarkTheta;
+    LayoutStats stats = ComponentLayout(graph, options, components);
+
+    cout << name << "," << graph.nodes.size() << "," << graph.edges.size() << ","
+         << (components.stress ? "stress" : "force") << "," << stats.graphIterations << ","
+         << stats.seconds << "," << stats.graphIterations / std::max(stats.seconds, 1e-9) << ","
+         << (stats.converged ? 1 : 0) << "," << stats.energy << ",";
+#ifndef _WIN32
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    cout << usage.ru_maxrss / 1024;
+#else
+    cout << usage.ru_maxrss;
+#endif
+#endif
+    cout << endl;
+    return true;
+}
+
+// Parse the flags, then run every graph, in a child process where there
+// are processes to fork
+int RunSuiteBenchmark(int argc, char **argv) {
+    LayoutOptions options;
+    options.seconds = kSuiteSeconds;
+    options.draw = false;
+    ComponentOptions components;
+    components.multilevelMinNodes = kSuiteMultilevelMinNodes;
+    int first = 2;
+    for (; first + 1 < argc && argv[first][0] == '-'; first += 2) {
+        std::string flag = argv[first], value = argv[first + 1];
+        if (flag == "--seconds") options.seconds = std::atof(value.c_str());
+        else if (flag == "--seed") components.seed = std::strtoul(value.c_str(), NULL, 10);
+        else if (flag == "--engine" && value == "force") components.stress = false;
+        else if (flag == "--engine" && value == "stress") components.stress = true;
+        else break;
+    }
+    if ((first < argc && argv[first][0] == '-') || options.seconds <= 0) {
+        std::cerr << "Usage: " << argv[0] << " --benchmark-suite [--seconds S] [--engine force|stress]"
+                  << " [--seed S] [<graph-file> | <family>:<nodes>]..." << endl;
+        return 1;
+    }
+
+    vector<std::string> graphs(argv + first, argv + argc);
+    if (graphs.empty())
+        graphs.assign(kSuiteGraphs, kSuiteGraphs + sizeof(kSuiteGraphs) / sizeof(kSuiteGraphs[0]));
+
+    cout << "graph,nodes,edges,engine,graph_iterations,seconds,graph_iterations_per_second,"
+         << "converged,energy,peak_rss_kb" << endl;
+    int status = 0;
+    for (size_t g = 0; g < graphs.size(); ++g) {
+#ifndef _WIN32
+        pid_t child = fork();
+        if (child == 0) {
+            bool ok = RunSuiteGraph(graphs[g], options, components);
+            cout.flush();
+            _exit(ok ? 0 : 1);
+        }
+        int childStatus = 1;
+        if (child < 0 || waitpid(child, &childStatus, 0) < 0 ||
+            !WIFEXITED(childStatus) || WEXITSTATUS(childStatus) != 0)
+            status = 1;
+#else
+        if (!RunSuiteGraph(graphs[g], options, components))
+            status = 1;
+#endif
+    }
+    return status;
+}
+
+// Allocations made by a run of the layout from the given positions
+static size_t CountAllocations(const SimpleGraph &start, const LayoutOptions &options,
+                               LayoutState &state) {
+    SimpleGraph graph(start);
+    size_t before = AllocationCount();
+    ForceDirected(graph, options, state);
+    return AllocationCount() - before;
+}
+
+// Parse the flags, then compare short and long runs in every mode
+int RunAllocationCheck(int argc, char **argv) {
+    int iterations = kCheckIterations;
+    int first = 2;
+    if (first + 1 < argc && std::string(argv[first]) == "--iterations") {
+        iterations = std::atoi(argv[first + 1]);
+        first += 2;
+    }
+    if (iterations < 2 || (first < argc && argv[first][0] == '-')) {
+        std::cerr << "Usage: " << argv[0] << " --check-allocations [--iterations N]"
+                  << " [<graph-file> | <family>:<nodes>]..." << endl;
+        return 1;
+    }
+    if (!kAllocationCountEnabled) {
+        std::cerr << "Sorry, this build does not count allocations; define GRAPHVIZ_COUNT_ALLOCATIONS" << endl;
+        return 1;
+    }
+
+    vector<std::string> graphs(argv + first, argv + argc);
+    if (graphs.empty())
+        graphs.assign(kCheckGraphs, kCheckGraphs + sizeof(kCheckGraphs) / sizeof(kCheckGraphs[0]));
+
+    const char *modes[] = {"all-pairs", "barnes-hut", "cutoff"};
+    cout << "graph,mode,threads,cold_run_allocations,warm_run_allocations,iteration_allocations" << endl;
+    int status = 0;
+    for (size_t g = 0; g < graphs.size(); ++g) {
+        SimpleGraph graph;
+        if (!GenerateGraph(graphs[g], 0, graph) && !LoadGraph(graph, graphs[g])) {
+            std::cerr << "Sorry, I can't read or generate the graph " << graphs[g] << endl;
+            return 1;
+        }
+
+        for (int m = 0; m < 3; ++m) {
+            for (int threads = 1; threads <= 2; ++threads) {
+                LayoutOptions options;
+                options.seconds = 0;
+                options.tolerance = 0;
+                options.draw = false;
+                options.threads = threads;
+                options.theta = m == 1 ? kBenchmarkTheta : 0.0;
+                options.cutoff = m == 2 ? kBenchmarkCutoff : 0.0;
+
+                // The first run sizes the state for every iteration to come;
+                // the runs after it only differ in their iterations
+                LayoutState state;
+                options.iterations = iterations;
+                size_t coldRun = CountAllocations(graph, options, state);
+                options.iterations = 1;
+                size_t shortRun = CountAllocations(graph, options, state);
+                options.iterations = iterations;
+                size_t longRun = CountAllocations(graph, options, state);
+
+                long extra = long(longRun) - long(shortRun);
+                cout << graphs[g] << "," << modes[m] << "," << threads << "," << coldRun << ","
+                     << shortRun << "," << extra << endl;
+                if (extra != 0) status = 1;
+            }
+        }
+    }
+    if (status != 0)
+        std::cerr << "Some layout iterations allocated memory" << endl;
+    return status;
+}
+
+// Whether every position is finite and every edge joins two existing nodes
+static bool IsSound(const SimpleGraph &graph) {
+    for (size_t i = 0; i < graph.nodes.size(); ++i) {
+        if (!std::isfinite(graph.nodes[i].x) || !std::isfinite(graph.nodes[i].y))
+            return false;
+    }
+    for (size_t e = 0; e < graph.edges.size(); ++e) {
+        if (graph.edges[e].start >= graph.nodes.size() || graph.edges[e].end >= graph.nodes.size())
+            return false;
+    }
+    return true;
+}
+
+// Print the outcome of one case of the incremental check
+static bool ReportCase(const char *name, const SimpleGraph &graph) {
+    bool sound = IsSound(graph);
+    cout << name << "," << graph.nodes.size() << "," << graph.edges.size() << ","
+         << (sound ? 1 : 0) << endl;
+    return sound;
+}
+
+// Run edit sequences that once broke IncrementalLayout, then random ones
+int RunIncrementalCheck(int argc, char **argv) {
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " --check-incremental" << endl;
+        return 1;
+    }
+
+    LayoutOptions options;
+    options.seconds = 0;
+    options.iterations = 100;
+    options.draw = false;
+    int status = 0;
+    cout << "case,nodes,edges,sound" << endl;
+
+    // Removing a changed node while the last node has changed too, which
+    // used to relax two copies of one node into NaN
+    SimpleGraph path;
+    path.nodes.resize(6);
+    for (size_t i = 0; i < 6; ++i) {
+        path.nodes[i].x = double(i);
+        path.nodes[i].y = 0;
+        if (i > 0) {
+            Edge edge = {i - 1, i};
+            path.edges.push_back(edge);
+        }
+    }
+    {
+        IncrementalLayout layout(path);
+        layout.addEdge(0, 5);
+        layout.removeNode(0);
+        layout.relax(options);
+    }
+    if (!ReportCase("remove-touched-with-touched-last", path)) status = 1;
+
+    // Random additions and removals of nodes and edges, relaxing after each
+    // round
+    SimpleGraph graph;
+    GenerateGraph(kEditGraph, 0, graph);
+    options.theta = 0;
+    ForceDirected(graph, options);
+    {
+        IncrementalLayout layout(graph);
+        std::mt19937 rng(0);
+        for (int round = 0; round < kEditRounds; ++round) {
+            for (int k = 0; k < 4; ++k) {
+                std::uniform_int_distribution<size_t> pick(0, graph.nodes.size() - 1);
+                switch (rng() % 4) {
+                case 0: layout.addEdge(layout.addNode(), pick(rng)); break;
+                case 1: layout.addEdge(pick(rng), pick(rng)); break;
+                case 2: layout.removeNode(pick(rng)); break;
+                default:
+                    if (!graph.edges.empty()) {
+                        Edge edge = graph.edges[rng() % graph.edges.size()];
+                        layout.removeEdge(edge.start, edge.end);
+                    }
+                }
+            }
+            layout.relax(options);
+        }
+    }
+    if (!ReportCase("random-edits", graph)) status = 1;
+
+    if (status != 0)
+        std::cerr << "Some incremental edits broke the layout" << endl;
+    return status;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+/*************************************************************************
+ * File: Benchmark.h
+ *
+ * Command-line benchmarks and checks of the layout engine, run without a
+ * window.
+ */
+
+/**
+ * Function: RunCutoffBenchmark(int argc, char** argv)
+ * -----------------------------------------------------------------------
+ * Handles "--benchmark [--copies N] [--iterations N] <graph-file>...".
+ * Every graph is scaled up by tiling 1, 4, 16, ... up to N copies of it
+ * (64 by default) and joining neighboring copies by an edge. Each scaled
+ * graph is laid out once, then timed for a fixed number of iterations
+ * (20 by default) with all-pairs, Barnes-Hut and cutoff repulsion, starting
+ * from the same positions. Prints one CSV line per graph, copy count and
+ * mode to standard output. Returns the exit code of the program.
+ */
+int RunCutoffBenchmark(int argc, char** argv);
+
+/**
+ * Function: RunPlacementBenchmark(int argc, char** argv)
+ * -----------------------------------------------------------------------
+ * Handles "--benchmark-placement [--seed S] <graph-file>...". Lays out
+ * every graph with plain ForceDirected from each initial placement in
+ * Placement.h, until it converges or hits an iteration limit, and prints
+ * one CSV line per graph and placement with the iterations and seconds it
+ * took. Returns the exit code of the program.
+ */
+int RunPlacementBenchmark(int argc, char** argv);
+
+/**
+ * Function: RunStressBenchmark(int argc, char** argv)
+ * -----------------------------------------------------------------------
+ * Handles "--benchmark-stress [--placement NAME] <graph-file>...". Lays
+ * out every graph with ForceDirected() and with StressLayout() from the
+ * same placement (bfs by default), under doubling iteration limits until
+ * the run converges, and prints one CSV line per run with its time and the
+ * normalized stress of the result, which traces time against quality for
+ * both engines. Returns the exit code of the program.
+ */
+int RunStressBenchmark(int argc, char** argv);
+
+/**
+ * Function: RunSuiteBenchmark(int argc, char** argv)
+ * -----------------------------------------------------------------------
+ * Handles "--benchmark-suite [--seconds S] [--engine force|stress]
+ * [--seed S] <graph>...", where every graph is a file or a generated graph
+ * such as "rgg:100000" (see GenerateGraph() in Generators.h). Without
+ * graphs, runs every graph in the resources folder, then every generated
+ * family at 1,000, 10,000 and 100,000 nodes. Each graph is laid out the
+ * way --headless does it by default, within S seconds (60 by default), and
+ * gets one CSV line with the passes over the whole graph, counted as in
+ * LayoutStats::graphIterations, and their rate, the time to convergence,
+ * the final energy and the peak resident memory in kB. On POSIX systems
+ * each graph runs in a child process of its own, so that the memory
+ * figures do not add up; elsewhere the peak memory is left empty. Returns
+ * the exit code of the program.
+ */
+int RunSuiteBenchmark(int argc, char** argv);
+
+/**
+ * Function: RunAllocationCheck(int argc, char** argv)
+ * -----------------------------------------------------------------------
+ * Handles "--check-allocations [--iterations N] [<graph>...]", where every
+ * graph is a file or a generated graph such as "rgg:2000" (see
+ * GenerateGraph() in Generators.h); without graphs, a grid and a random
+ * geometric graph of a few thousand nodes are used. Every graph is laid
+ * out with all-pairs, Barnes-Hut and cutoff repulsion, on one and on two
+ * threads, with a LayoutState that has already run N iterations (20 by
+ * default) from the same start. A run of 1 iteration and a run of N then
+ * make the same number of allocations, or the iterations in between made
+ * some. Prints one CSV line per graph, mode and thread count, with the
+ * allocations of a run with a fresh state and with a used one, and fails
+ * if any iteration allocated. Builds without GRAPHVIZ_COUNT_ALLOCATIONS
+ * (see Allocations.h) refuse to run it. Returns the exit code of the program.
+ */
+int RunAllocationCheck(int argc, char** argv);
+
+/**
+ * Function: RunIncrementalCheck(int argc, char** argv)
+ * -----------------------------------------------------------------------
+ * Handles "--check-incremental". Replays edit sequences through
+ * IncrementalLayout (see Incremental.h) that once corrupted the layout,
+ * then random additions and removals of nodes and edges on a small grid,
+ * relaxing after every round. Prints one CSV line per case, and fails if
+ * any case leaves a position that is not finite or an edge to a missing
+ * node. Returns the exit code of the program.
+ */
+int RunIncrementalCheck(int argc, char** argv);
@@ -0,0 +1,123 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "Checkpoint.h"
+
+using std::uint32_t;
+using std::uint64_t;
+
+// First bytes of a checkpoint file
+const char kCheckpointMagic[8] = {'G', 'V', 'C', 'K', 'P', 'T', '0', '1'};
+
+CheckpointWriter::CheckpointWriter(const std::string &path, int interval)
+    : path_(path), interval_(interval > 0 ? interval : 1) {
+    writer_ = std::thread(&CheckpointWriter::writerLoop, this);
+}
+
+CheckpointWriter::~CheckpointWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    writer_.join();
+}
+
+int CheckpointWriter::interval() const {
+    return interval_;
+}
+
+// Copy into the buffers, in the graph's node order, unless the writer
+// still owns them
+bool CheckpointWriter::save(const SolverState &state, std::size_t numEdges, const double *xs,
+                            const double *ys, const std::vector<uint32_t> &order, std::size_t n) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pending_ || writing_) return false;
+    }
+    xs_.resize(n);
+    ys_.resize(n);
+    for (std::size_t k = 0; k < n; ++k) {
+        std::size_t i = order.empty() ? k : order[k];
+        xs_[i] = xs[k];
+        ys_[i] = ys[k];
+    }
+    state_ = state;
+    numEdges_ = numEdges;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_ = true;
+    }
+    wake_.notify_all();
+    return true;
+}
+
+bool CheckpointWriter::failed() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return failed_;
+}
+
+// Wait for a checkpoint, write it to a temporary file and rename that over
+// the target. Exits once stopped with nothing left to write.
+void CheckpointWriter::writerLoop() {
+    std::string temporary = path_ + ".tmp";
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (!pending_ && !stopping_)
+                wake_.wait(lock);
+            if (!pending_) return;
+            pending_ = false;
+            writing_ = true;
+        }
+
+        bool ok;
+        {
+            std::ofstream output(temporary.c_str(), std::ios::binary);
+            uint64_t counts[2] = {xs_.size(), numEdges_};
+            output.write(kCheckpointMagic, sizeof(kCheckpointMagic));
+            output.write(reinterpret_cast<const char*>(counts), sizeof(counts));
+            output.write(reinterpret_cast<const char*>(&state_), sizeof(state_));
+            output.write(reinterpret_cast<const char*>(xs_.data()), xs_.size() * sizeof(double));
+            output.write(reinterpret_cast<const char*>(ys_.data()), ys_.size() * sizeof(double));
+            output.close();
+            ok = bool(output);
+        }
+#ifdef _WIN32
+        // rename() does not replace an existing file here
+        std::remove(path_.c_str());
+#endif
+        ok = ok && std::rename(temporary.c_str(), path_.c_str()) == 0;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        writing_ = false;
+        failed_ = failed_ || !ok;
+    }
+}
+
+// Check the header against the graph before touching it
+bool LoadCheckpoint(const std::string &path, SimpleGraph &graph, SolverState &state) {
+    std::ifstream input(path.c_str(), std::ios::binary);
+    char magic[sizeof(kCheckpointMagic)];
+    uint64_t counts[2];
+    SolverState loaded;
+    input.read(magic, sizeof(magic));
+    input.read(reinterpret_cast<char*>(counts), sizeof(counts));
+    input.read(reinterpret_cast<char*>(&loaded), sizeof(loaded));
+    if (!input || std::memcmp(magic, kCheckpointMagic, sizeof(magic)) != 0 ||
+        counts[0] != graph.nodes.size() || counts[1] != graph.edges.size())
+        return false;
+
+    std::vector<double> xs(counts[0]), ys(counts[0]);
+    input.read(reinterpret_cast<char*>(xs.data()), xs.size() * sizeof(double));
+    input.read(reinterpret_cast<char*>(ys.data()), ys.size() * sizeof(double));
+    if (!input) return false;
+
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        graph.nodes[i].x = xs[i];
+        graph.nodes[i].y = ys[i];
+    }
+    state = loaded;
+    return true;
+}
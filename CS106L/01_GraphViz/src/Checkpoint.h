@@ -0,0 +1,96 @@
+#pragma once
+
+/*************************************************************************
+ * File: Checkpoint.h
+ *
+ * Checkpoints of a running force-directed layout, so that a long run that
+ * gets killed can pick up where it left off. A checkpoint holds the node
+ * positions and everything ForceDirected() carries from one iteration to
+ * the next; with both, a resumed run takes exactly the steps the original
+ * would have taken.
+ *
+ * A checkpoint file holds the 8 bytes "GVCKPT01", the number of nodes and
+ * of edges as 64-bit integers, the solver state, then the x and then the y
+ * coordinates of the nodes as doubles, all in the byte order of the machine
+ * that wrote it. The file is written next to the target and renamed over
+ * it, so the latest complete checkpoint survives a kill in mid-write.
+ */
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SimpleGraph.h"
+
+/**
+ * Type: SolverState
+ * -----------------------------------------------------------------------
+ * The state of ForceDirected() between two iterations. The solver draws no
+ * random numbers, so there is no generator state to keep.
+ */
+struct SolverState {
+    std::uint64_t iterations = 0;   // Iterations run so far
+    double seconds = 0.0;           // Time spent so far
+    double temperature = 0.0;
+    double step = 0.0;
+    double prevEnergy = 0.0;
+    std::int64_t progress = 0;      // Energy drops in a row
+};
+
+/**
+ * Type: CheckpointWriter
+ * -----------------------------------------------------------------------
+ * Writes checkpoints to one file on a thread of its own. save() only copies
+ * the state into a buffer and returns; if the previous checkpoint is still
+ * being written, it skips this one rather than wait, so the layout never
+ * stalls on the disk. The destructor finishes the last write.
+ */
+class CheckpointWriter {
+public:
+    /* Writes to path every interval iterations. */
+    CheckpointWriter(const std::string& path, int interval);
+    ~CheckpointWriter();
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    int interval() const;
+
+    /* Queues a checkpoint of the state and of the n positions xs[k], ys[k],
+     * which belong to node order[k], or node k if order is empty. Returns
+     * false if a write was still in progress and this one was skipped. */
+    bool save(const SolverState& state, std::size_t numEdges, const double* xs, const double* ys,
+              const std::vector<std::uint32_t>& order, std::size_t n);
+
+    /* Whether any write so far has failed. */
+    bool failed();
+
+private:
+    void writerLoop();
+
+    std::string path_;
+    int interval_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool pending_ = false;     // A checkpoint waits in the buffers below
+    bool writing_ = false;
+    bool stopping_ = false;
+    bool failed_ = false;
+    SolverState state_;
+    std::uint64_t numEdges_ = 0;
+    std::vector<double> xs_, ys_;
+    std::thread writer_;
+};
+
+/**
+ * Function: LoadCheckpoint(path, graph, state)
+ * -----------------------------------------------------------------------
+ * Reads a checkpoint of a layout of the graph into its node positions and
+ * state. Returns false, leaving both alone, if the file cannot be read or
+ * is not a checkpoint of a graph with this many nodes and edges.
+ */
+bool LoadCheckpoint(const std::string& path, SimpleGraph& graph, SolverState& state);
@@ -0,0 +1,263 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <vector>
+
+#include "Components.h"
+#include "Multilevel.h"
+#include "Stress.h"
+#include "ThreadPool.h"
+
+using std::size_t;
+using std::vector;
+
+// While the components are laid out, the packed graph is drawn at most this
+// often, and every component hands over its positions at most this often
+const std::chrono::milliseconds kComponentFrameInterval(20);
+
+// The root of node i's set, halving the path on the way up
+static size_t FindRoot(vector<size_t> &parent, size_t i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+// Union the endpoints of every edge, smaller set under the larger, then
+// number the roots in node order
+size_t FindComponents(size_t numNodes, const vector<Edge> &edges, vector<size_t> &component) {
+    vector<size_t> parent(numNodes), setSize(numNodes, 1);
+    for (size_t i = 0; i < numNodes; ++i)
+        parent[i] = i;
+    for (size_t e = 0; e < edges.size(); ++e) {
+        size_t a = FindRoot(parent, edges[e].start), b = FindRoot(parent, edges[e].end);
+        if (a == b) continue;
+        if (setSize[a] < setSize[b]) std::swap(a, b);
+        parent[b] = a;
+        setSize[a] += setSize[b];
+    }
+
+    const size_t kUnlabeled = size_t(-1);
+    vector<size_t> label(numNodes, kUnlabeled);
+    size_t count = 0;
+    component.resize(numNodes);
+    for (size_t i = 0; i < numNodes; ++i) {
+        size_t root = FindRoot(parent, i);
+        if (label[root] == kUnlabeled) label[root] = count++;
+        component[i] = label[root];
+    }
+    return count;
+}
+
+// Lay out one component from its placement
+static LayoutStats LayOut(SimpleGraph &graph, const LayoutOptions &options,
+                          const ComponentOptions &components, LayoutState &state) {
+    if (graph.nodes.size() < 2) {
+        LayoutStats stats;
+        stats.converged = true;
+        return stats;
+    }
+    if (components.stress)
+        return StressLayout(graph, options);
+    if (graph.nodes.size() >= components.multilevelMinNodes)
+        return MultilevelLayout(graph, options, MultilevelOptions(), state);
+    if (graph.nodes.size() < components.approximateMinNodes) {
+        LayoutOptions exact = options;
+        exact.theta = 0;
+        exact.cutoff = 0;
+        return ForceDirected(graph, exact, state);
+    }
+    return ForceDirected(graph, options, state);
+}
+
+// Pack the components, at the given positions, into graph: the padded
+// bounding boxes go tallest first, ties largest first, into rows as wide
+// as the square root of the total area, or the widest box, with one mean
+// edge length between them
+static void Pack(const vector<SimpleGraph> &parts, const vector<vector<Node> > &positions,
+                 const vector<vector<size_t> > &members, const vector<size_t> &bySize,
+                 SimpleGraph &graph) {
+    size_t count = parts.size();
+    double gap = 0;
+    size_t numEdges = 0;
+    for (size_t c = 0; c < count; ++c) {
+        for (size_t e = 0; e < parts[c].edges.size(); ++e) {
+            const Node &a = positions[c][parts[c].edges[e].start];
+            const Node &b = positions[c][parts[c].edges[e].end];
+            gap += std::hypot(a.x - b.x, a.y - b.y);
+            ++numEdges;
+        }
+    }
+    gap = numEdges > 0 && gap > 0 ? gap / numEdges : 1.0;
+
+    vector<double> minX(count), minY(count), width(count), height(count);
+    vector<size_t> byHeight(bySize);
+    double area = 0, widest = 0;
+    for (size_t c = 0; c < count; ++c) {
+        const vector<Node> &nodes = positions[c];
+        double maxX = nodes[0].x, maxY = nodes[0].y;
+        minX[c] = maxX;
+        minY[c] = maxY;
+        for (size_t i = 1; i < nodes.size(); ++i) {
+            minX[c] = std::min(minX[c], nodes[i].x);
+            maxX = std::max(maxX, nodes[i].x);
+            minY[c] = std::min(minY[c], nodes[i].y);
+            maxY = std::max(maxY, nodes[i].y);
+        }
+        width[c] = maxX - minX[c] + gap;
+        height[c] = maxY - minY[c] + gap;
+        area += width[c] * height[c];
+        widest = std::max(widest, width[c]);
+    }
+    std::stable_sort(byHeight.begin(), byHeight.end(), [&](size_t a, size_t b) {
+        return height[a] > height[b];
+    });
+
+    double rowWidth = std::max(std::sqrt(area), widest);
+    double x = 0, y = 0, rowHeight = 0;
+    for (size_t k = 0; k < count; ++k) {
+        size_t c = byHeight[k];
+        if (x > 0 && x + width[c] > rowWidth) {
+            x = 0;
+            y += rowHeight;
+            rowHeight = 0;
+        }
+        for (size_t i = 0; i < members[c].size(); ++i) {
+            graph.nodes[members[c][i]].x = positions[c][i].x - minX[c] + x;
+            graph.nodes[members[c][i]].y = positions[c][i].y - minY[c] + y;
+        }
+        x += width[c];
+        rowHeight = std::max(rowHeight, height[c]);
+    }
+}
+
+// Lay out the components in a state of their own
+LayoutStats ComponentLayout(SimpleGraph &graph, const LayoutOptions &options,
+                            const ComponentOptions &components) {
+    LayoutState state;
+    return ComponentLayout(graph, options, components, state);
+}
+
+// Split the graph into components, lay them out, then pack them in shelves
+LayoutStats ComponentLayout(SimpleGraph &graph, const LayoutOptions &options,
+                            const ComponentOptions &components, LayoutState &state) {
+    auto startTime = std::chrono::steady_clock::now();
+    vector<size_t> component;
+    size_t count = FindComponents(graph.nodes.size(), graph.edges, component);
+    if (count <= 1) {
+        components.placement(graph, components.seed);
+        LayoutOptions whole = options;
+        whole.seconds = SecondsLeft(options, startTime);
+        return LayOut(graph, whole, components, state);
+    }
+
+    // Copy every component into a graph of its own, remembering where its
+    // nodes came from, and place it
+    vector<SimpleGraph> parts(count);
+    vector<vector<size_t> > members(count);
+    vector<size_t> local(graph.nodes.size());
+    for (size_t i = 0; i < graph.nodes.size(); ++i) {
+        local[i] = members[component[i]].size();
+        members[component[i]].push_back(i);
+    }
+    for (size_t c = 0; c < count; ++c)
+        parts[c].nodes.resize(members[c].size());
+    for (size_t e = 0; e < graph.edges.size(); ++e) {
+        Edge edge = {local[graph.edges[e].start], local[graph.edges[e].end]};
+        parts[component[graph.edges[e].start]].edges.push_back(edge);
+    }
+    for (size_t c = 0; c < count; ++c)
+        components.placement(parts[c], components.seed);
+
+    // Largest first, so that the parallel run does not end on a big one
+    vector<size_t> bySize(count);
+    for (size_t c = 0; c < count; ++c)
+        bySize[c] = c;
+    std::stable_sort(bySize.begin(), bySize.end(), [&](size_t a, size_t b) {
+        return members[a].size() > members[b].size();
+    });
+
+    // When drawing, every component copies its positions into shown now and
+    // then, and whichever thread finds a frame due packs them into the graph
+    // and draws it, so the window shows the whole graph as it takes shape
+    vector<vector<Node> > shown(count);
+    std::mutex drawMutex;
+    auto lastFrame = std::chrono::steady_clock::time_point();
+    if (options.draw) {
+        for (size_t c = 0; c < count; ++c)
+            shown[c] = parts[c].nodes;
+    }
+    auto optionsFor = [&](const LayoutOptions &base, size_t c) {
+        LayoutOptions part = base;
+        if (!options.draw) return part;
+        auto lastCopy = std::chrono::steady_clock::time_point();
+        part.onDraw = [&, c, lastCopy](SimpleGraph &laidOut) mutable {
+            auto now = std::chrono::steady_clock::now();
+            if (now - lastCopy < kComponentFrameInterval) return;
+            std::unique_lock<std::mutex> lock(drawMutex, std::try_to_lock);
+            if (!lock.owns_lock()) return;
+            lastCopy = now;
+            shown[c] = laidOut.nodes;
+            if (now - lastFrame < kComponentFrameInterval) return;
+            lastFrame = now;
+            Pack(parts, shown, members, bySize, graph);
+            DrawGraph(graph);
+        };
+        return part;
+    };
+
+    // The time limit covers the whole call. A large component gets the
+    // share of the time left that its nodes make of those not laid out yet;
+    // the small ones, which run side by side, get all that is left after.
+    vector<LayoutStats> partStats(count);
+    size_t next = 0, nodesLeft = graph.nodes.size();
+    for (; next < count && members[bySize[next]].size() >= components.sharedPoolMinNodes; ++next) {
+        size_t c = bySize[next];
+        LayoutOptions large = optionsFor(options, c);
+        large.seconds = SecondsLeft(options, startTime) * members[c].size() / nodesLeft;
+        nodesLeft -= members[c].size();
+        partStats[c] = LayOut(parts[c], large, components, state);
+    }
+
+    // Every thread takes the next small component until none is left,
+    // thread 0 in the caller's state and the others in one each. The
+    // telemetry buffer is not thread-safe, so these runs go unrecorded.
+    LayoutOptions smallOptions = options;
+    smallOptions.threads = 1;
+    smallOptions.telemetry = nullptr;
+    std::atomic<size_t> cursor(next);
+    ThreadPool pool(options.threads);
+    vector<LayoutState> threadStates(next < count ? pool.size() - 1 : 0);
+    pool.run([&](size_t t) {
+        LayoutState &threadState = t == 0 ? state : threadStates[t - 1];
+        for (size_t k = cursor++; k < count; k = cursor++) {
+            size_t c = bySize[k];
+            LayoutOptions small = optionsFor(smallOptions, c);
+            small.seconds = SecondsLeft(options, startTime);
+            partStats[c] = LayOut(parts[c], small, components, threadState);
+        }
+    });
+
+    for (size_t c = 0; c < count; ++c)
+        shown[c].swap(parts[c].nodes);
+    Pack(parts, shown, members, bySize, graph);
+
+    LayoutStats stats;
+    stats.converged = true;
+    for (size_t c = 0; c < count; ++c) {
+        stats.iterations += partStats[c].iterations;
+        stats.graphIterations +=
+            partStats[c].graphIterations * members[c].size() / graph.nodes.size();
+        stats.energy += partStats[c].energy;
+        stats.maxDisplacement = std::max(stats.maxDisplacement, partStats[c].maxDisplacement);
+        stats.converged = stats.converged && partStats[c].converged;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+    stats.seconds = elapsed.count();
+    if (options.draw)
+        DrawGraph(graph);
+    return stats;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+/*************************************************************************
+ * File: Components.h
+ *
+ * Layout of graphs with several connected components. Nodes in different
+ * components never pull on each other, so laying the whole graph out at
+ * once only spends repulsion on pairs that merely need to stay apart, and
+ * lets the components push each other around. Instead, every component is
+ * laid out on its own, the small ones in parallel, and the finished
+ * layouts are packed side by side.
+ */
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "SimpleGraph.h"
+#include "Layout.h"
+#include "Placement.h"
+
+/**
+ * Function: FindComponents(std::size_t numNodes, const std::vector<Edge>& edges,
+ *                          std::vector<std::size_t>& component)
+ * -----------------------------------------------------------------------
+ * Labels the connected components of the graph with union-find, setting
+ * component[i] to the component of node i. Components are numbered from 0
+ * in the order of their lowest node. Returns the number of components.
+ */
+std::size_t FindComponents(std::size_t numNodes, const std::vector<Edge>& edges,
+                           std::vector<std::size_t>& component);
+
+/**
+ * Type: ComponentOptions
+ * -----------------------------------------------------------------------
+ * Settings of a component-wise layout on top of the LayoutOptions.
+ *
+ * Every component starts from its own placement. With stress set, every
+ * component is laid out by StressLayout() (see Stress.h). Otherwise,
+ * components with at least multilevelMinNodes nodes use the multilevel
+ * scheme (see Multilevel.h), the others plain ForceDirected(). Components
+ * with fewer than
+ * approximateMinNodes nodes ignore theta and cutoff and use the exact
+ * all-pairs repulsion: it is cheap on them, and the error of Barnes-Hut
+ * can keep a small layout jittering forever. Components with at least
+ * sharedPoolMinNodes nodes are laid out one after another, each with all
+ * the threads in the options; the smaller ones run side by side, one per
+ * thread.
+ */
+struct ComponentOptions {
+    PlacementStrategy placement = PlaceOnCircle;
+    unsigned seed = 0;
+    bool stress = false;
+    std::size_t multilevelMinNodes = std::numeric_limits<std::size_t>::max();
+    std::size_t approximateMinNodes = 1000;
+    std::size_t sharedPoolMinNodes = 2000;
+};
+
+/**
+ * Function: ComponentLayout(SimpleGraph& graph, const LayoutOptions& options,
+ *                           const ComponentOptions& components)
+ * -----------------------------------------------------------------------
+ * Lays out every connected component of the graph separately, ignoring the
+ * current node positions, then packs the bounding boxes of the components
+ * into rows, tallest first, leaving a mean edge length between them. The
+ * time limit in options covers the whole call: the large components, laid
+ * out one after another, each get the share of the time left that their
+ * nodes make of those still to lay out, and the small ones, laid out side
+ * by side, get whatever is left after them. The other limits apply to
+ * every component. With options.draw set, the packed graph is drawn as
+ * the components take shape, and once more at the end. Returns the
+ * iterations and energies of all components added up, the largest last
+ * displacement, the wall-clock time, and whether every component
+ * converged.
+ *
+ * The second form lays the components out in the given state (see
+ * LayoutState in Layout.h), one after another, and in states of their own
+ * on the other threads, so that a caller laying out many graphs keeps the
+ * arrays from one graph to the next.
+ */
+LayoutStats ComponentLayout(SimpleGraph& graph, const LayoutOptions& options,
+                            const ComponentOptions& components = ComponentOptions());
+LayoutStats ComponentLayout(SimpleGraph& graph, const LayoutOptions& options,
+                            const ComponentOptions& components, LayoutState& state);
@@ -0,0 +1,108 @@
+#include <cmath>
+
+#include "ForceKernels.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define FORCE_KERNELS_AVX2 1
+#endif
+
+// Repulsion of node i with nodes j in [begin, n), in plain C++
+static void RepelRow(const double *x, const double *y, std::size_t i, std::size_t begin,
+                     std::size_t n, double kRepel, double *fx, double *fy) {
+    double xi = x[i], yi = y[i];
+    double fxi = 0, fyi = 0;
+    for (std::size_t j = begin; j < n; ++j) {
+        double dx = x[j] - xi;
+        double dy = y[j] - yi;
+        double f = kRepel / (dx * dx + dy * dy);
+        fxi -= f * dx;
+        fyi -= f * dy;
+        fx[j] += f * dx;
+        fy[j] += f * dy;
+    }
+    fx[i] += fxi;
+    fy[i] += fyi;
+}
+
+static void RepelRowsScalar(const double *x, const double *y, std::size_t n,
+                            std::size_t rowBegin, std::size_t rowEnd,
+                            double kRepel, double *fx, double *fy) {
+    for (std::size_t i = rowBegin; i < rowEnd && i + 1 < n; ++i)
+        RepelRow(x, y, i, i + 1, n, kRepel, fx, fy);
+}
+
+#ifdef FORCE_KERNELS_AVX2
+// Same loop four pairs at a time. Node i's force is kept in a register and
+// reduced once per row; the j side is a plain load-add-store since the four
+// lanes touch four different nodes.
+__attribute__((target("avx2")))
+static void RepelRowsAvx2(const double *x, const double *y, std::size_t n,
+                          std::size_t rowBegin, std::size_t rowEnd,
+                          double kRepel, double *fx, double *fy) {
+    const __m256d k = _mm256_set1_pd(kRepel);
+    for (std::size_t i = rowBegin; i < rowEnd && i + 1 < n; ++i) {
+        const __m256d xi = _mm256_set1_pd(x[i]);
+        const __m256d yi = _mm256_set1_pd(y[i]);
+        __m256d fxi = _mm256_setzero_pd();
+        __m256d fyi = _mm256_setzero_pd();
+
+        std::size_t j = i + 1;
+        for (; j + 4 <= n; j += 4) {
+            __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(x + j), xi);
+            __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(y + j), yi);
+            __m256d d2 = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+            __m256d f = _mm256_div_pd(k, d2);
+            __m256d px = _mm256_mul_pd(f, dx);
+            __m256d py = _mm256_mul_pd(f, dy);
+            fxi = _mm256_sub_pd(fxi, px);
+            fyi = _mm256_sub_pd(fyi, py);
+            _mm256_storeu_pd(fx + j, _mm256_add_pd(_mm256_loadu_pd(fx + j), px));
+            _mm256_storeu_pd(fy + j, _mm256_add_pd(_mm256_loadu_pd(fy + j), py));
+        }
+
+        double lanes[4];
+        _mm256_storeu_pd(lanes, fxi);
+        fx[i] += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        _mm256_storeu_pd(lanes, fyi);
+        fy[i] += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+
+        // Leftover pairs of the row
+        RepelRow(x, y, i, j, n, kRepel, fx, fy);
+    }
+}
+#endif
+
+void RepelRows(const double *x, const double *y, std::size_t n,
+               std::size_t rowBegin, std::size_t rowEnd,
+               double kRepel, double *fx, double *fy) {
+#ifdef FORCE_KERNELS_AVX2
+    static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+    if (hasAvx2) {
+        RepelRowsAvx2(x, y, n, rowBegin, rowEnd, kRepel, fx, fy);
+        return;
+    }
+#endif
+    RepelRowsScalar(x, y, n, rowBegin, rowEnd, kRepel, fx, fy);
+}
+
+// Sum the pulls on node i in registers, then store once
+void AttractNeighbors(const double *x, const double *y,
+                      const std::uint32_t *offsets, const std::uint32_t *neighbors,
+                      std::size_t begin, std::size_t end,
+                      double kAttract, double *fx, double *fy) {
+    for (std::size_t i = begin; i < end; ++i) {
+        double xi = x[i], yi = y[i];
+        double fxi = 0, fyi = 0;
+        for (std::uint32_t k = offsets[i]; k < offsets[i + 1]; ++k) {
+            std::uint32_t j = neighbors[k];
+            double dx = x[j] - xi;
+            double dy = y[j] - yi;
+            double f = kAttract * std::sqrt(dx * dx + dy * dy);
+            fxi += f * dx;
+            fyi += f * dy;
+        }
+        fx[i] += fxi;
+        fy[i] += fyi;
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+/*************************************************************************
+ * File: ForceKernels.h
+ *
+ * The inner loops of the layout, on structure-of-arrays positions: x[i] and
+ * y[i] are the coordinates of node i, and the kernels add the forces they
+ * compute to fx[i] and fy[i].
+ *
+ * The kernels never compute an angle. The force between two nodes acts
+ * along the line between them, whose direction is (dx, dy) / d, so a force
+ * of size F contributes F * (dx, dy) / d. For the repulsion F = kRepel / d,
+ * giving kRepel * (dx, dy) / d^2, which needs no square root at all; for the
+ * attraction F = kAttract * d^2, giving kAttract * d * (dx, dy).
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Function: RepelRows(x, y, n, rowBegin, rowEnd, kRepel, fx, fy)
+ * -----------------------------------------------------------------------
+ * Adds the repulsion of the pairs (i, j) with rowBegin <= i < rowEnd and
+ * i < j < n; the range [0, n) gives every pair. Splitting [0, n) into row
+ * ranges splits the all-pairs sum into independent pieces; note that a row
+ * range writes to fx[j] and fy[j] for every j >= rowBegin. Uses AVX2 when
+ * the CPU supports it.
+ */
+void RepelRows(const double* x, const double* y, std::size_t n,
+               std::size_t rowBegin, std::size_t rowEnd,
+               double kRepel, double* fx, double* fy);
+
+/**
+ * Function: AttractNeighbors(x, y, offsets, neighbors, begin, end, kAttract, fx, fy)
+ * -----------------------------------------------------------------------
+ * Adds to every node i with begin <= i < end the attraction of its
+ * neighbors, given in CSR form as neighbors[offsets[i], offsets[i + 1]).
+ * Every edge is evaluated from both ends, but each node only writes its own
+ * force, so node ranges can run in parallel without private copies.
+ */
+void AttractNeighbors(const double* x, const double* y,
+                      const std::uint32_t* offsets, const std::uint32_t* neighbors,
+                      std::size_t begin, std::size_t end,
+                      double kAttract, double* fx, double* fy);
@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "Generators.h"
+#include "Placement.h"
+
+using std::size_t;
+using std::vector;
+
+// Constant number
+const double kPi = 3.14159265358979323;
+
+// Mean degree of the random families in GenerateGraph
+const double kDefaultMeanDegree = 6.0;
+
+// Start the graph with its nodes on the unit circle and no edges
+static void MakeNodes(size_t numNodes, SimpleGraph &graph) {
+    graph.nodes.assign(numNodes, Node());
+    graph.edges.clear();
+    PlaceOnCircle(graph, 0);
+}
+
+// Bin the points into cells one radius wide, then compare every point with
+// the later points of its own cell and with the four cells after it
+void RandomGeometricGraph(size_t numNodes, double meanDegree, unsigned seed, SimpleGraph &graph) {
+    MakeNodes(numNodes, graph);
+    if (numNodes < 2) return;
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    vector<double> xs(numNodes), ys(numNodes);
+    for (size_t i = 0; i < numNodes; ++i) {
+        xs[i] = uniform(rng);
+        ys[i] = uniform(rng);
+    }
+
+    double radius = std::sqrt(meanDegree / (kPi * numNodes));
+    size_t side = std::max<size_t>(1, size_t(1.0 / radius));
+    vector<vector<size_t> > cells(side * side);
+    for (size_t i = 0; i < numNodes; ++i) {
+        size_t cx = std::min(side - 1, size_t(xs[i] * side));
+        size_t cy = std::min(side - 1, size_t(ys[i] * side));
+        cells[cy * side + cx].push_back(i);
+    }
+
+    const int kForward[4][2] = {{1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+    for (size_t cy = 0; cy < side; ++cy) {
+        for (size_t cx = 0; cx < side; ++cx) {
+            const vector<size_t> &cell = cells[cy * side + cx];
+            for (size_t a = 0; a < cell.size(); ++a) {
+                size_t i = cell[a];
+                for (size_t b = a + 1; b < cell.size(); ++b) {
+                    size_t j = cell[b];
+                    if (std::hypot(xs[i] - xs[j], ys[i] - ys[j]) < radius) {
+                        Edge edge = {i, j};
+                        graph.edges.push_back(edge);
+                    }
+                }
+                for (int k = 0; k < 4; ++k) {
+                    size_t nx = cx + kForward[k][0], ny = cy + kForward[k][1];
+                    if (nx >= side || ny >= side) continue;
+                    const vector<size_t> &other = cells[ny * side + nx];
+                    for (size_t b = 0; b < other.size(); ++b) {
+                        size_t j = other[b];
+                        if (std::hypot(xs[i] - xs[j], ys[i] - ys[j]) < radius) {
+                            Edge edge = {i, j};
+                            graph.edges.push_back(edge);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Draw pairs, then drop self-loops and repeats
+void ErdosRenyiGraph(size_t numNodes, double meanDegree, unsigned seed, SimpleGraph &graph) {
+    MakeNodes(numNodes, graph);
+    if (numNodes < 2) return;
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<size_t> pick(0, numNodes - 1);
+    size_t numEdges = size_t(numNodes * meanDegree / 2);
+    vector<std::pair<size_t, size_t> > pairs;
+    pairs.reserve(numEdges);
+    for (size_t k = 0; k < numEdges; ++k) {
+        size_t a = pick(rng), b = pick(rng);
+        if (a == b) continue;
+        pairs.push_back(std::make_pair(std::min(a, b), std::max(a, b)));
+    }
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+    graph.edges.reserve(pairs.size());
+    for (size_t k = 0; k < pairs.size(); ++k) {
+        Edge edge = {pairs[k].first, pairs[k].second};
+        graph.edges.push_back(edge);
+    }
+}
+
+void GridGraph(size_t numNodes, SimpleGraph &graph) {
+    size_t side = size_t(std::sqrt(double(numNodes)) + 0.5);
+    MakeNodes(side * side, graph);
+    for (size_t row = 0; row < side; ++row) {
+        for (size_t col = 0; col < side; ++col) {
+            size_t i = row * side + col;
+            if (col + 1 < side) {
+                Edge edge = {i, i + 1};
+                graph.edges.push_back(edge);
+            }
+            if (row + 1 < side) {
+                Edge edge = {i, i + side};
+                graph.edges.push_back(edge);
+            }
+        }
+    }
+}
+
+// Preferential attachment: a node of degree d appears d times in ends, so
+// picking a uniform entry of it picks a node in proportion to its degree.
+// The first edgesPerNode + 1 nodes form a clique to start from.
+void ScaleFreeGraph(size_t numNodes, size_t edgesPerNode, unsigned seed, SimpleGraph &graph) {
+    MakeNodes(numNodes, graph);
+    size_t core = std::min(numNodes, edgesPerNode + 1);
+    vector<size_t> ends;
+    for (size_t i = 0; i < core; ++i) {
+        for (size_t j = i + 1; j < core; ++j) {
+            Edge edge = {i, j};
+            graph.edges.push_back(edge);
+            ends.push_back(i);
+            ends.push_back(j);
+        }
+    }
+
+    std::mt19937_64 rng(seed);
+    vector<size_t> targets;
+    for (size_t i = core; i < numNodes; ++i) {
+        targets.clear();
+        while (targets.size() < edgesPerNode) {
+            size_t j = ends[std::uniform_int_distribution<size_t>(0, ends.size() - 1)(rng)];
+            if (std::find(targets.begin(), targets.end(), j) == targets.end())
+                targets.push_back(j);
+        }
+        for (size_t k = 0; k < targets.size(); ++k) {
+            Edge edge = {i, targets[k]};
+            graph.edges.push_back(edge);
+            ends.push_back(i);
+            ends.push_back(targets[k]);
+        }
+    }
+}
+
+bool GenerateGraph(const std::string &spec, unsigned seed, SimpleGraph &graph) {
+    size_t colon = spec.find(':');
+    if (colon == std::string::npos) return false;
+    std::string family = spec.substr(0, colon);
+    char *end;
+    unsigned long long numNodes = std::strtoull(spec.c_str() + colon + 1, &end, 10);
+    if (*end != '\0' || end == spec.c_str() + colon + 1) return false;
+
+    if (family == "rgg") RandomGeometricGraph(numNodes, kDefaultMeanDegree, seed, graph);
+    else if (family == "er") ErdosRenyiGraph(numNodes, kDefaultMeanDegree, seed, graph);
+    else if (family == "grid") GridGraph(numNodes, graph);
+    else if (family == "ba") ScaleFreeGraph(numNodes, size_t(kDefaultMeanDegree / 2), seed, graph);
+    else return false;
+    return true;
+}
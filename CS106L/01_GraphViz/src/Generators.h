@@ -0,0 +1,60 @@
+#pragma once
+
+/*************************************************************************
+ * File: Generators.h
+ *
+ * Synthetic graphs for benchmarking the layout at sizes the bundled res/
+ * graphs do not reach. Every generator is seeded, so the same arguments
+ * give the same graph, and puts the nodes on the unit circle, as
+ * LoadGraph() does.
+ */
+
+#include <cstddef>
+#include <string>
+
+#include "SimpleGraph.h"
+
+/**
+ * Function: RandomGeometricGraph(numNodes, meanDegree, seed, graph)
+ * -----------------------------------------------------------------------
+ * Scatters the nodes uniformly in the unit square and joins every pair
+ * closer than the radius that gives the requested mean degree. Sparse,
+ * local and, at a mean degree of 6 or more, mostly connected: the kind of
+ * graph force layouts draw well.
+ */
+void RandomGeometricGraph(std::size_t numNodes, double meanDegree, unsigned seed,
+                          SimpleGraph& graph);
+
+/**
+ * Function: ErdosRenyiGraph(numNodes, meanDegree, seed, graph)
+ * -----------------------------------------------------------------------
+ * Joins numNodes * meanDegree / 2 distinct pairs of nodes chosen uniformly
+ * at random. Has no geometry at all, so no layout can make its edges short.
+ */
+void ErdosRenyiGraph(std::size_t numNodes, double meanDegree, unsigned seed, SimpleGraph& graph);
+
+/**
+ * Function: GridGraph(numNodes, graph)
+ * -----------------------------------------------------------------------
+ * A square grid of about numNodes nodes, with side the rounded square root.
+ */
+void GridGraph(std::size_t numNodes, SimpleGraph& graph);
+
+/**
+ * Function: ScaleFreeGraph(numNodes, edgesPerNode, seed, graph)
+ * -----------------------------------------------------------------------
+ * A Barabasi-Albert graph: every node after the first few joins
+ * edgesPerNode distinct earlier nodes, chosen in proportion to their
+ * degree, which gives a few hubs and many nodes of low degree.
+ */
+void ScaleFreeGraph(std::size_t numNodes, std::size_t edgesPerNode, unsigned seed,
+                    SimpleGraph& graph);
+
+/**
+ * Function: GenerateGraph(const std::string& spec, unsigned seed, SimpleGraph& graph)
+ * -----------------------------------------------------------------------
+ * Builds the graph named by spec, "family:nodes" with family one of rgg,
+ * er, grid or ba, such as "rgg:100000". The random families have a mean
+ * degree of 6. Returns false if spec names no such graph.
+ */
+bool GenerateGraph(const std::string& spec, unsigned seed, SimpleGraph& graph);
@@ -0,0 +1,191 @@
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "GraphIO.h"
+#include "Placement.h"
+
+using std::uint32_t;
+using std::uint64_t;
+
+// Binary format: magic, node count, edge count, then the edges
+const char kBinaryMagic[8] = {'G', 'V', 'E', 'D', 'G', 'E', 'S', '1'};
+const std::size_t kBinaryHeaderSize = sizeof(kBinaryMagic) + 2 * sizeof(uint64_t);
+
+MappedFile::MappedFile() : data_(NULL), size_(0), mapped_(false) {}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+// Map the file where possible, read it otherwise
+bool MappedFile::open(const std::string &path) {
+    close();
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void *map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            madvise(map, info.st_size, MADV_SEQUENTIAL);
+            data_ = static_cast<const char*>(map);
+            size_ = info.st_size;
+            mapped_ = true;
+        }
+    }
+    ::close(fd);
+    if (mapped_) return true;
+#endif
+    std::ifstream input(path.c_str(), std::ios::binary);
+    if (!input.is_open()) return false;
+    buffer_.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+    return true;
+}
+
+void MappedFile::close() {
+#ifndef _WIN32
+    if (mapped_) munmap(const_cast<char*>(data_), size_);
+#endif
+    data_ = NULL;
+    size_ = 0;
+    mapped_ = false;
+    std::string().swap(buffer_);
+}
+
+const char *MappedFile::data() const {
+    return data_;
+}
+
+std::size_t MappedFile::size() const {
+    return size_;
+}
+
+// Check the magic and that the file holds exactly the edges it announces
+static bool ReadBinaryHeader(const MappedFile &file, std::size_t &numNodes, std::size_t &numEdges) {
+    if (file.size() < kBinaryHeaderSize ||
+        std::memcmp(file.data(), kBinaryMagic, sizeof(kBinaryMagic)) != 0)
+        return false;
+
+    uint64_t counts[2];
+    std::memcpy(counts, file.data() + sizeof(kBinaryMagic), sizeof(counts));
+    if (counts[0] > std::numeric_limits<uint32_t>::max() ||
+        counts[1] != (file.size() - kBinaryHeaderSize) / (2 * sizeof(uint32_t)) ||
+        (file.size() - kBinaryHeaderSize) % (2 * sizeof(uint32_t)) != 0)
+        return false;
+    numNodes = counts[0];
+    numEdges = counts[1];
+    return true;
+}
+
+// Make the nodes and put them evenly on the unit circle
+static void PlaceNodes(SimpleGraph &graph, std::size_t numNodes) {
+    graph.nodes.resize(numNodes);
+    PlaceOnCircle(graph, 0);
+}
+
+// Parse an unsigned integer at p, skipping leading whitespace. Returns false
+// at the end of the text or at anything that is not a number, like the
+// formatted reads it replaces.
+static bool ParseNumber(const char *&p, const char *end, std::size_t &value) {
+    while (p != end && (*p == ' ' || unsigned(*p - '\t') <= '\r' - '\t'))
+        ++p;
+    if (p == end || unsigned(*p - '0') > 9) return false;
+    std::size_t result = 0;
+    for (unsigned digit; p != end && (digit = unsigned(*p - '0')) <= 9; ++p)
+        result = result * 10 + digit;
+    value = result;
+    return true;
+}
+
+// Load graph, including nodes and edges
+bool LoadGraph(SimpleGraph &graph, const std::string &path) {
+    graph.nodes.clear();
+    graph.edges.clear();
+    ++graph.edgeVersion;
+
+    MappedFile file;
+    if (!file.open(path)) return false;
+
+    // Binary files: the edges are read straight from the mapping
+    std::size_t numNodes, numEdges;
+    if (ReadBinaryHeader(file, numNodes, numEdges)) {
+        const uint32_t *pairs = reinterpret_cast<const uint32_t*>(file.data() + kBinaryHeaderSize);
+        graph.edges.resize(numEdges);
+        for (std::size_t i = 0; i < numEdges; ++i) {
+            if (pairs[2 * i] >= numNodes || pairs[2 * i + 1] >= numNodes) {
+                graph.edges.clear();
+                return false;
+            }
+            graph.edges[i].start = pairs[2 * i];
+            graph.edges[i].end = pairs[2 * i + 1];
+        }
+        PlaceNodes(graph, numNodes);
+        return true;
+    }
+
+    const char *p = file.data(), *end = p + file.size();
+    std::size_t nodes_num = 0;
+    ParseNumber(p, end, nodes_num);
+
+    // Files hold one edge per line, so the lines give the reserve
+    std::size_t lines = 0;
+    for (const char *q = p; (q = static_cast<const char*>(std::memchr(q, '\n', end - q))) != NULL; ++q)
+        ++lines;
+    graph.edges.reserve(lines);
+    std::size_t start, finish;
+    while (ParseNumber(p, end, start) && ParseNumber(p, end, finish)) {
+        if (start >= nodes_num || finish >= nodes_num) {
+            graph.edges.clear();
+            return false;
+        }
+        struct Edge edge = {start, finish};
+        graph.edges.push_back(edge);
+    }
+    PlaceNodes(graph, nodes_num);
+    return true;
+}
+
+// Header, then the edges as 32-bit pairs in blocks
+bool WriteBinaryGraph(const SimpleGraph &graph, const std::string &path) {
+    if (graph.nodes.size() > std::numeric_limits<uint32_t>::max()) return false;
+    std::ofstream output(path.c_str(), std::ios::binary);
+    if (!output.is_open()) return false;
+
+    uint64_t counts[2] = {graph.nodes.size(), graph.edges.size()};
+    output.write(kBinaryMagic, sizeof(kBinaryMagic));
+    output.write(reinterpret_cast<const char*>(counts), sizeof(counts));
+
+    const std::size_t kBlockEdges = 1 << 16;
+    std::vector<uint32_t> block;
+    block.reserve(2 * kBlockEdges);
+    for (std::size_t i = 0; i < graph.edges.size(); ++i) {
+        block.push_back(graph.edges[i].start);
+        block.push_back(graph.edges[i].end);
+        if (block.size() == 2 * kBlockEdges || i + 1 == graph.edges.size()) {
+            output.write(reinterpret_cast<const char*>(block.data()), block.size() * sizeof(uint32_t));
+            block.clear();
+        }
+    }
+    return bool(output);
+}
+
+// Write the coordinates with enough digits to read them back exactly
+void WriteLayout(const SimpleGraph &graph, std::ostream &output) {
+    output << graph.nodes.size() << '\n';
+    output << std::setprecision(17);
+    for (size_t i = 0; i < graph.nodes.size(); ++i)
+        output << graph.nodes[i].x << ' ' << graph.nodes[i].y << '\n';
+}
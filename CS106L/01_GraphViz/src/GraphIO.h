@@ -0,0 +1,77 @@
+#pragma once
+
+/*************************************************************************
+ * File: GraphIO.h
+ *
+ * Reading graphs from files and writing finished layouts back out.
+ *
+ * Graphs come in two formats, told apart by their first bytes:
+ *
+ *   - Text: the number of nodes followed by one "start end" pair of node
+ *     indices per edge, separated by any whitespace.
+ *   - Binary: the 8 bytes "GVEDGES1", the number of nodes and of edges as
+ *     two 64-bit integers, then every edge as two 32-bit node indices, all
+ *     in the byte order of the machine that wrote it.
+ *
+ * A layout file holds the number of nodes followed by one "x y" line per
+ * node.
+ */
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+#include "SimpleGraph.h"
+
+/**
+ * Type: MappedFile
+ * -----------------------------------------------------------------------
+ * A read-only view of a whole file. On POSIX systems the file is mapped
+ * into memory, so nothing is read until it is touched; elsewhere it is read
+ * into a buffer.
+ */
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile& rhs) = delete;
+    MappedFile& operator=(const MappedFile& rhs) = delete;
+
+    /* Opens the file, returning false if it cannot be read. */
+    bool open(const std::string& path);
+    void close();
+
+    const char* data() const;
+    std::size_t size() const;
+
+private:
+    const char* data_;
+    std::size_t size_;
+    bool mapped_;
+    std::string buffer_;   // Holds the file where it is not mapped
+};
+
+/**
+ * Function: LoadGraph(SimpleGraph& graph, const std::string& path)
+ * -----------------------------------------------------------------------
+ * Reads the nodes and edges of a graph file in either format, placing the
+ * nodes evenly on the unit circle. Returns false, leaving the graph empty,
+ * if the file cannot be read or names a node that does not exist.
+ */
+bool LoadGraph(SimpleGraph& graph, const std::string& path);
+
+/**
+ * Function: WriteBinaryGraph(const SimpleGraph& graph, const std::string& path)
+ * -----------------------------------------------------------------------
+ * Writes the edges of the graph in the binary format, returning whether it
+ * succeeded. The graph must have fewer than 2^32 nodes.
+ */
+bool WriteBinaryGraph(const SimpleGraph& graph, const std::string& path);
+
+/**
+ * Function: WriteLayout(const SimpleGraph& graph, std::ostream& output)
+ * -----------------------------------------------------------------------
+ * Writes the node coordinates of the graph as a layout file.
+ */
+void WriteLayout(const SimpleGraph& graph, std::ostream& output);
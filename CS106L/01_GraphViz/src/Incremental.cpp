@@ -0,0 +1,281 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "Incremental.h"
+
+using std::size_t;
+using std::vector;
+
+// Random offset of a new node from the mean of its neighbors, in local
+// edge lengths, so that nodes added together do not coincide
+const double kSeedJitter = 0.1;
+
+// Regions smaller than this use the exact all-pairs repulsion
+const size_t kRegionApproximateMinNodes = 1000;
+
+// Index the edges of every node
+IncrementalLayout::IncrementalLayout(SimpleGraph &graph, const IncrementalOptions &options)
+    : graph_(graph), options_(options), incident_(graph.nodes.size()),
+      isTouched_(graph.nodes.size(), 0), isNew_(graph.nodes.size(), 0), updates_(0) {
+    for (size_t e = 0; e < graph_.edges.size(); ++e) {
+        incident_[graph_.edges[e].start].push_back(e);
+        if (graph_.edges[e].end != graph_.edges[e].start)
+            incident_[graph_.edges[e].end].push_back(e);
+    }
+}
+
+size_t IncrementalLayout::addNode() {
+    Node node = {0, 0};
+    graph_.nodes.push_back(node);
+    incident_.push_back(vector<size_t>());
+    isTouched_.push_back(0);
+    isNew_.push_back(1);
+    touch(graph_.nodes.size() - 1);
+    return graph_.nodes.size() - 1;
+}
+
+// Drop the node's edges, then move the last node into its place and
+// renumber that node's edges and entries
+void IncrementalLayout::removeNode(size_t node) {
+    while (!incident_[node].empty()) {
+        const Edge &edge = graph_.edges[incident_[node].back()];
+        touch(edge.start == node ? edge.end : edge.start);
+        eraseEdge(incident_[node].back());
+    }
+
+    size_t last = graph_.nodes.size() - 1;
+    if (node != last) {
+        graph_.nodes[node] = graph_.nodes[last];
+        incident_[node].swap(incident_[last]);
+        for (size_t k = 0; k < incident_[node].size(); ++k) {
+            Edge &edge = graph_.edges[incident_[node][k]];
+            if (edge.start == last) edge.start = node;
+            if (edge.end == last) edge.end = node;
+        }
+        ++graph_.edgeVersion;
+        isNew_[node] = isNew_[last];
+        if (isTouched_[last] && isTouched_[node]) {
+            touched_.erase(std::find(touched_.begin(), touched_.end(), last));
+        }
+        else if (isTouched_[last]) {
+            std::replace(touched_.begin(), touched_.end(), last, node);
+            isTouched_[node] = 1;
+        }
+        else if (isTouched_[node]) {
+            touched_.erase(std::find(touched_.begin(), touched_.end(), node));
+            isTouched_[node] = 0;
+        }
+    }
+    else if (isTouched_[node]) {
+        touched_.erase(std::find(touched_.begin(), touched_.end(), node));
+    }
+    graph_.nodes.pop_back();
+    incident_.pop_back();
+    isTouched_.pop_back();
+    isNew_.pop_back();
+}
+
+void IncrementalLayout::addEdge(size_t a, size_t b) {
+    if (a == b || findEdge(a, b) != size_t(-1)) return;
+    Edge edge = {a, b};
+    graph_.edges.push_back(edge);
+    ++graph_.edgeVersion;
+    incident_[a].push_back(graph_.edges.size() - 1);
+    incident_[b].push_back(graph_.edges.size() - 1);
+    touch(a);
+    touch(b);
+}
+
+void IncrementalLayout::removeEdge(size_t a, size_t b) {
+    size_t edge = findEdge(a, b);
+    if (edge == size_t(-1)) return;
+    eraseEdge(edge);
+    touch(a);
+    touch(b);
+}
+
+// The index of the edge between a and b, searched at the lower degree end,
+// or -1 if there is none
+size_t IncrementalLayout::findEdge(size_t a, size_t b) const {
+    if (incident_[a].size() > incident_[b].size()) std::swap(a, b);
+    for (size_t k = 0; k < incident_[a].size(); ++k) {
+        const Edge &edge = graph_.edges[incident_[a][k]];
+        if ((edge.start == a && edge.end == b) || (edge.start == b && edge.end == a))
+            return incident_[a][k];
+    }
+    return size_t(-1);
+}
+
+// Remove the edge by moving the last edge into its slot
+void IncrementalLayout::eraseEdge(size_t edge) {
+    const Edge removed = graph_.edges[edge];
+    vector<size_t> *lists[] = {&incident_[removed.start], &incident_[removed.end]};
+    for (int k = 0; k < 2; ++k)
+        lists[k]->erase(std::find(lists[k]->begin(), lists[k]->end(), edge));
+
+    size_t last = graph_.edges.size() - 1;
+    if (edge != last) {
+        const Edge moved = graph_.edges[last];
+        graph_.edges[edge] = moved;
+        std::replace(incident_[moved.start].begin(), incident_[moved.start].end(), last, edge);
+        std::replace(incident_[moved.end].begin(), incident_[moved.end].end(), last, edge);
+    }
+    graph_.edges.pop_back();
+    ++graph_.edgeVersion;
+}
+
+void IncrementalLayout::touch(size_t node) {
+    if (isTouched_[node]) return;
+    isTouched_[node] = 1;
+    touched_.push_back(node);
+}
+
+// Put every new node at the mean of its placed neighbors, in waves, so
+// that chains of new nodes grow out of the old layout. New nodes that
+// never reach it go next to a random old node, or the origin.
+void IncrementalLayout::placeNewNodes() {
+    std::mt19937 rng(options_.seed + updates_);
+    std::uniform_real_distribution<double> jitter(-kSeedJitter, kSeedJitter);
+
+    vector<size_t> waiting;
+    for (size_t k = 0; k < touched_.size(); ++k) {
+        if (isNew_[touched_[k]]) waiting.push_back(touched_[k]);
+    }
+    size_t numOld = graph_.nodes.size() - waiting.size();
+    while (!waiting.empty()) {
+        vector<size_t> next, placed;
+        vector<Node> positions;
+        for (size_t k = 0; k < waiting.size(); ++k) {
+            size_t u = waiting[k];
+            double x = 0, y = 0, length = 0;
+            size_t count = 0, numLengths = 0;
+            for (size_t j = 0; j < incident_[u].size(); ++j) {
+                const Edge &edge = graph_.edges[incident_[u][j]];
+                size_t v = edge.start == u ? edge.end : edge.start;
+                if (isNew_[v]) continue;
+                x += graph_.nodes[v].x;
+                y += graph_.nodes[v].y;
+                for (size_t i = 0; i < incident_[v].size(); ++i) {
+                    const Edge &far = graph_.edges[incident_[v][i]];
+                    if (isNew_[far.start] || isNew_[far.end]) continue;
+                    const Node &a = graph_.nodes[far.start], &b = graph_.nodes[far.end];
+                    length += std::hypot(a.x - b.x, a.y - b.y);
+                    ++numLengths;
+                }
+                ++count;
+            }
+            if (count == 0) {
+                next.push_back(u);
+                continue;
+            }
+            length = numLengths > 0 && length > 0 ? length / numLengths : 1.0;
+            Node node = {x / count + length * jitter(rng), y / count + length * jitter(rng)};
+            placed.push_back(u);
+            positions.push_back(node);
+        }
+
+        // Nothing new touches the layout: start from somewhere and go on
+        if (placed.empty()) {
+            size_t u = next.back();
+            next.pop_back();
+            Node node = {jitter(rng), jitter(rng)};
+            if (numOld > 0) {
+                const Node &anchor = graph_.nodes[std::uniform_int_distribution<size_t>(0, numOld - 1)(rng)];
+                node.x += anchor.x;
+                node.y += anchor.y;
+            }
+            placed.push_back(u);
+            positions.push_back(node);
+        }
+        for (size_t k = 0; k < placed.size(); ++k) {
+            graph_.nodes[placed[k]] = positions[k];
+            isNew_[placed[k]] = 0;
+        }
+        waiting.swap(next);
+    }
+}
+
+// Seed the new nodes, relax the region around the changes with its
+// boundary pinned, then now and then give the whole layout a short
+// low-temperature pass
+LayoutStats IncrementalLayout::relax(const LayoutOptions &options) {
+    auto startTime = std::chrono::steady_clock::now();
+    placeNewNodes();
+    ++updates_;
+
+    // Breadth-first out to regionHops from the changed nodes; the next
+    // layer is the boundary. index maps graph nodes to the region graph.
+    vector<size_t> nodes(touched_);
+    std::sort(nodes.begin(), nodes.end());
+    size_t head = 0;
+    std::unordered_map<size_t, size_t> index;
+    for (size_t k = 0; k < nodes.size(); ++k)
+        index[nodes[k]] = k;
+    size_t regionSize = 0;
+    for (int hop = 0; hop <= options_.regionHops; ++hop) {
+        regionSize = nodes.size();
+        for (size_t end = nodes.size(); head < end; ++head) {
+            size_t u = nodes[head];
+            for (size_t k = 0; k < incident_[u].size(); ++k) {
+                const Edge &edge = graph_.edges[incident_[u][k]];
+                size_t v = edge.start == u ? edge.end : edge.start;
+                if (index.count(v)) continue;
+                index[v] = nodes.size();
+                nodes.push_back(v);
+            }
+        }
+    }
+
+    SimpleGraph region;
+    region.nodes.resize(nodes.size());
+    for (size_t k = 0; k < nodes.size(); ++k)
+        region.nodes[k] = graph_.nodes[nodes[k]];
+    for (size_t k = 0; k < regionSize; ++k) {
+        size_t u = nodes[k];
+        for (size_t j = 0; j < incident_[u].size(); ++j) {
+            const Edge &edge = graph_.edges[incident_[u][j]];
+            size_t v = index[edge.start == u ? edge.end : edge.start];
+            if (v < regionSize && v < k) continue;
+            Edge copy = {k, v};
+            region.edges.push_back(copy);
+        }
+    }
+    for (size_t k = 0; k < touched_.size(); ++k)
+        isTouched_[touched_[k]] = 0;
+    touched_.clear();
+
+    LayoutStats stats;
+    stats.converged = true;
+    if (regionSize > 0) {
+        LayoutOptions local = options;
+        local.draw = false;
+        local.reorder = false;
+        local.fixedFrom = regionSize < nodes.size() ? regionSize : 0;
+        if (nodes.size() < kRegionApproximateMinNodes) {
+            local.theta = 0;
+            local.cutoff = 0;
+        }
+        stats = ForceDirected(region, local, state_);
+        for (size_t k = 0; k < regionSize; ++k)
+            graph_.nodes[nodes[k]] = region.nodes[k];
+    }
+
+    if (options_.globalInterval > 0 && updates_ % options_.globalInterval == 0 &&
+        options_.globalIterations > 0 && graph_.nodes.size() > 1) {
+        LayoutOptions global = options;
+        global.draw = false;
+        global.iterations = options_.globalIterations;
+        global.temperature = options_.globalTemperature;
+        stats.iterations += ForceDirected(graph_, global, state_).iterations;
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+    stats.seconds = elapsed.count();
+    if (options.draw)
+        DrawGraph(graph_);
+    return stats;
+}
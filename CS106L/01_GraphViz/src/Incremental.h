@@ -0,0 +1,86 @@
+#pragma once
+
+/*************************************************************************
+ * File: Incremental.h
+ *
+ * Incremental layout of a graph that changes over time. Nodes and edges
+ * are added and removed through an IncrementalLayout, which keeps an index
+ * of the edges at every node so that each change costs time in the degree
+ * of the nodes it touches. relax() then seeds the new nodes next to their
+ * neighbors and runs the force-directed layout on the region around the
+ * changes only, with the rest of the layout held in place, so an update
+ * costs time in the size of the change rather than of the graph.
+ */
+
+#include <cstddef>
+#include <vector>
+
+#include "SimpleGraph.h"
+#include "Layout.h"
+
+/**
+ * Type: IncrementalOptions
+ * -----------------------------------------------------------------------
+ * Settings of relax() on top of the LayoutOptions.
+ *
+ * The region relaxed is every node within regionHops edges of a changed
+ * node; the neighbors just outside it stay put but still pull on it.
+ * Inside the region, nodes only repel the region and its boundary, so it
+ * can end up overlapping distant parts of the layout. Every
+ * globalInterval-th call to relax() therefore ends with globalIterations
+ * iterations over the whole graph at globalTemperature, which let the rest
+ * of the layout make room. They cost as much as ordinary iterations over
+ * the whole graph, far more than relaxing a region, so they are spread
+ * out; set globalInterval to 0 to never run them.
+ */
+struct IncrementalOptions {
+    int regionHops = 2;
+    int globalInterval = 10;
+    int globalIterations = 2;
+    double globalTemperature = 0.001;
+    unsigned seed = 0;                 // Seed of the jitter of new nodes
+};
+
+/**
+ * Type: IncrementalLayout
+ * -----------------------------------------------------------------------
+ * Edits a graph that was laid out before, then relaxes the layout around
+ * the edits. The graph must outlive this object and must only be changed
+ * through it.
+ *
+ * addNode() appends a node and returns its index. removeNode(i) removes
+ * the node and its edges, then moves the last node into index i, so that
+ * the indices stay dense; the caller must follow that renumbering.
+ * Duplicate edges and self-loops are ignored, as are removals of edges that
+ * do not exist.
+ */
+class IncrementalLayout {
+public:
+    IncrementalLayout(SimpleGraph& graph, const IncrementalOptions& options = IncrementalOptions());
+
+    std::size_t addNode();
+    void removeNode(std::size_t node);
+    void addEdge(std::size_t a, std::size_t b);
+    void removeEdge(std::size_t a, std::size_t b);
+
+    /* Places the nodes added since the last call and relaxes the layout
+     * around every change since then, with the limits in options. The
+     * graph is drawn once at the end if options.draw is set.
+     */
+    LayoutStats relax(const LayoutOptions& options);
+
+private:
+    std::size_t findEdge(std::size_t a, std::size_t b) const;
+    void eraseEdge(std::size_t edge);
+    void touch(std::size_t node);
+    void placeNewNodes();
+
+    SimpleGraph& graph_;
+    IncrementalOptions options_;
+    std::vector<std::vector<std::size_t> > incident_;   // Edge indices at every node
+    std::vector<std::size_t> touched_;                  // Nodes changed since relax()
+    std::vector<char> isTouched_;
+    std::vector<char> isNew_;                           // Added and not yet placed
+    unsigned updates_;                                  // Calls to relax()
+    LayoutState state_;                                 // Shared by all the relaxations
+};
@@ -0,0 +1,364 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "Layout.h"
+#include "Checkpoint.h"
+#include "ForceKernels.h"
+#include "Telemetry.h"
+
+using std::uint32_t;
+using std::vector;
+
+// Constant number
+const double kRepel = 1e-3;
+const double kAttract = 1e-3;
+
+// Cooling schedule: iterations in a row that must lower the energy before
+// the layout speeds up again, the largest multiple of the forces a node may
+// move by, and the lowest temperature in tolerances, so that cooling alone
+// never passes for convergence
+const int kHeatingStreak = 5;
+const double kMaxStep = 64.0;
+const double kMinTemperature = 10.0;
+
+// The all-pairs loop is cut into this many tiles of rows, or one per node
+// in smaller graphs. The tiles depend only on the node count and are added
+// up in tile order, so the forces come out the same for any thread count.
+const size_t kRepelTiles = 32;
+
+// Row i of the all-pairs loop has n - 1 - i pairs, so equal row ranges would
+// give the first thread most of the work. Returns row bounds that give
+// every part about the same number of pairs.
+static vector<size_t> BalancedRowBounds(size_t n, size_t parts) {
+    vector<size_t> bounds(parts + 1, n);
+    bounds[0] = 0;
+    double total = 0.5 * n * (n - 1.0);
+    double pairs = 0;
+    size_t part = 1;
+    for (size_t i = 0; i < n && part < parts; ++i) {
+        pairs += n - 1.0 - i;
+        while (part < parts && pairs >= total * part / parts)
+            bounds[part++] = i + 1;
+    }
+    return bounds;
+}
+
+// The diagonal of the bounding box of the nodes, the unit the tolerance and
+// the temperature are measured in
+static double LayoutSize(const double *xs, const double *ys, size_t n) {
+    if (n == 0)
+        return 1.0;
+    double minX = xs[0], maxX = xs[0], minY = ys[0], maxY = ys[0];
+    for (size_t i = 1; i < n; ++i) {
+        minX = std::min(minX, xs[i]);
+        maxX = std::max(maxX, xs[i]);
+        minY = std::min(minY, ys[i]);
+        maxY = std::max(maxY, ys[i]);
+    }
+    double size = std::hypot(maxX - minX, maxY - minY);
+    return size > 0 ? size : 1.0;
+}
+
+// The mean length of the edges, the unit of the repulsion cutoff. Without
+// edges, the spacing the nodes would have on an even grid.
+static double MeanEdgeLength(const double *xs, const double *ys, const Adjacency &adjacency) {
+    size_t n = adjacency.numNodes();
+    if (adjacency.neighbors.empty())
+        return LayoutSize(xs, ys, n) / std::sqrt(double(std::max<size_t>(n, 1)));
+    double length = 0;
+    for (size_t i = 0; i < n; ++i) {
+        for (uint32_t k = adjacency.offsets[i]; k < adjacency.offsets[i + 1]; ++k) {
+            double dx = xs[i] - xs[adjacency.neighbors[k]];
+            double dy = ys[i] - ys[adjacency.neighbors[k]];
+            length += std::sqrt(dx * dx + dy * dy);
+        }
+    }
+    length /= adjacency.neighbors.size();
+    return length > 0 ? length : 1.0;
+}
+
+// Copy the positions back into graph.nodes, in the graph's own node order
+static void StorePositions(const vector<double> &xs, const vector<double> &ys,
+                           const vector<uint32_t> &order, SimpleGraph &graph) {
+    for (size_t k = 0; k < xs.size(); ++k) {
+        size_t i = order.empty() ? k : order[k];
+        graph.nodes[i].x = xs[k];
+        graph.nodes[i].y = ys[k];
+    }
+}
+
+// Seconds since start, moving start up to now
+static double Lap(std::chrono::steady_clock::time_point &start) {
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<double> lap = now - start;
+    start = now;
+    return lap.count();
+}
+
+// The limit left over, never so small that it reads as no limit at all
+double SecondsLeft(const LayoutOptions &options, std::chrono::steady_clock::time_point start,
+                   double reserve) {
+    const double kMinSecondsLeft = 1e-6;
+    if (options.seconds <= 0) return 0;
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return std::max(options.seconds - elapsed.count() - reserve, kMinSecondsLeft);
+}
+
+// Implement the Force Directed algorithm in a state of its own
+LayoutStats ForceDirected(SimpleGraph &graph, const LayoutOptions &options) {
+    LayoutState state;
+    return ForceDirected(graph, options, state);
+}
+
+// Implement the Force Directed algorithm. Positions and forces live in
+// separate x/y arrays of the state during the run, in the reordered node
+// numbering if there is one, and are copied back into graph.nodes for
+// drawing. Everything an iteration touches is sized here, before the loop.
+LayoutStats ForceDirected(SimpleGraph &graph, const LayoutOptions &options, LayoutState &state) {
+    auto startTime = std::chrono::steady_clock::now();
+    LayoutStats stats;
+    size_t size = graph.nodes.size();
+
+    // The edges as CSR lists, with the nodes renumbered for locality
+    Adjacency &adjacency = state.adjacency_;
+    vector<uint32_t> &order = state.order_;
+    order.clear();
+    if (options.reorder) {
+        BuildAdjacency(size, graph.edges, state.unordered_);
+        ReverseCuthillMcKee(state.unordered_, order, state.reorderScratch_);
+        PermuteAdjacency(state.unordered_, order, adjacency, state.reorderScratch_);
+    }
+    else {
+        BuildAdjacency(size, graph.edges, adjacency);
+    }
+
+    vector<double> &xs = state.xs_, &ys = state.ys_;
+    vector<double> &deltXs = state.deltXs_, &deltYs = state.deltYs_;
+    xs.resize(size);
+    ys.resize(size);
+    deltXs.resize(size);
+    deltYs.resize(size);
+    for (size_t k = 0; k < size; ++k) {
+        size_t i = order.empty() ? k : order[k];
+        xs[k] = graph.nodes[i].x;
+        ys[k] = graph.nodes[i].y;
+    }
+
+    if (!state.pool_ || state.poolThreads_ != options.threads) {
+        state.pool_.reset(new ThreadPool(options.threads));
+        state.poolThreads_ = options.threads;
+    }
+    ThreadPool &pool = *state.pool_;
+    size_t numThreads = pool.size();
+    bool cutoff = options.cutoff > 0;
+    bool barnesHut = !cutoff && options.theta > 0;
+    bool allPairs = !cutoff && !barnesHut;
+    size_t numTiles = allPairs ? std::min(kRepelTiles, size) : 0;
+    vector<size_t> &tileBounds = state.tileBounds_;
+    tileBounds = BalancedRowBounds(size, numTiles);
+
+    // Per-tile force accumulators for the all-pairs loop, whose rows write
+    // to nodes of other tiles. A tile only writes to nodes from its first
+    // row on, so its arrays start there.
+    vector<vector<double> > &accXs = state.accXs_, &accYs = state.accYs_;
+    if (accXs.size() < numTiles) {
+        accXs.resize(numTiles);
+        accYs.resize(numTiles);
+    }
+    for (size_t k = 0; k < numTiles; ++k) {
+        accXs[k].resize(size - tileBounds[k]);
+        accYs[k].resize(size - tileBounds[k]);
+    }
+
+    // Nodes move step times their force, at most temperature times the
+    // layout size
+    double temperature = options.temperature;
+    double step = 1.0;
+    double minTemperature = std::min(kMinTemperature * options.tolerance, options.temperature);
+    double prevEnergy = HUGE_VAL;
+    int progress = 0;
+    double secondsBefore = 0;
+    if (options.resume) {
+        stats.iterations = options.resume->iterations;
+        secondsBefore = options.resume->seconds;
+        temperature = options.resume->temperature;
+        step = options.resume->step;
+        prevEnergy = options.resume->prevEnergy;
+        progress = int(options.resume->progress);
+    }
+
+    // Phase timers and movement sums, for builds with telemetry
+    bool measure = kTelemetryEnabled && options.telemetry != nullptr;
+    IterationRecord record;
+    vector<double> &threadRepulsion = state.threadRepulsion_, &threadAttraction = state.threadAttraction_;
+    threadRepulsion.resize(numThreads);
+    threadAttraction.resize(numThreads);
+    std::chrono::steady_clock::time_point lapStart;
+    std::size_t droppedFrames = measure && options.draw ? DroppedFrames() : 0;
+
+    QuadTree &tree = state.tree_;
+    SpatialGrid &grid = state.grid_;
+
+    // The phases handed to the pool are wrapped in a std::function once per
+    // run, not once per iteration: wrapping lambdas this size allocates.
+    // Every thread takes every numThreads-th tile and sums its rows of
+    // pairs into the tile's arrays.
+    std::function<void(size_t)> repelRows = [&](size_t t) {
+        for (size_t k = t; k < numTiles; k += numThreads) {
+            size_t first = tileBounds[k];
+            double *fx = accXs[k].data(), *fy = accYs[k].data();
+            std::fill(fx, fx + size - first, 0.0);
+            std::fill(fy, fy + size - first, 0.0);
+            RepelRows(xs.data() + first, ys.data() + first, size - first,
+                      0, tileBounds[k + 1] - first, kRepel, fx, fy);
+        }
+    };
+
+    // Every thread owns a range of nodes: it adds up the all-pairs arrays in
+    // tile order, or asks the tree or grid, then gathers the pull of the
+    // neighbors
+    std::function<void(size_t)> gatherForces = [&](size_t t) {
+        std::chrono::steady_clock::time_point threadStart;
+        if (measure)
+            threadStart = std::chrono::steady_clock::now();
+        size_t begin = SplitRange(size, numThreads, t);
+        size_t end = SplitRange(size, numThreads, t + 1);
+        for (size_t i = begin; i < end; ++i) {
+            double dx = 0, dy = 0;
+            for (size_t k = 0; k < numTiles && tileBounds[k] <= i; ++k) {
+                dx += accXs[k][i - tileBounds[k]];
+                dy += accYs[k][i - tileBounds[k]];
+            }
+            if (barnesHut)
+                tree.repulsion(xs.data(), ys.data(), i, options.theta, kRepel, dx, dy);
+            if (cutoff)
+                grid.repulsion(xs.data(), ys.data(), i, kRepel, dx, dy);
+            deltXs[i] = dx;
+            deltYs[i] = dy;
+        }
+        if (measure)
+            threadRepulsion[t] = Lap(threadStart);
+        AttractNeighbors(xs.data(), ys.data(), adjacency.offsets.data(), adjacency.neighbors.data(),
+                         begin, end, kAttract, deltXs.data(), deltYs.data());
+        if (measure)
+            threadAttraction[t] = Lap(threadStart);
+    };
+
+    while(true) {
+        if (measure)
+            lapStart = std::chrono::steady_clock::now();
+
+        if (allPairs)
+            pool.run(repelRows);
+        if (barnesHut)
+            tree.build(xs.data(), ys.data(), size);
+        if (cutoff) {
+            double radius = options.cutoff * MeanEdgeLength(xs.data(), ys.data(), adjacency);
+            grid.build(xs.data(), ys.data(), size, radius);
+        }
+        if (measure)
+            record.repulsionSeconds = Lap(lapStart);
+
+        pool.run(gatherForces);
+        if (measure) {
+            Lap(lapStart);
+            record.repulsionSeconds += *std::max_element(threadRepulsion.begin(), threadRepulsion.end());
+            record.attractionSeconds = *std::max_element(threadAttraction.begin(), threadAttraction.end());
+            record.maxForce = record.totalDisplacement = 0;
+        }
+
+        // Move every node, then cool down if the energy went up and warm up
+        // again after steady progress
+        double scale = LayoutSize(xs.data(), ys.data(), size);
+        double maxStep = temperature > 0 ? temperature * scale : HUGE_VAL;
+        double energy = 0, maxDisplacement2 = 0;
+        for (size_t i = 0; i < size; ++i) {
+            if (options.fixedFrom > 0 && (order.empty() ? i : order[i]) >= options.fixedFrom)
+                continue;
+            double length2 = deltXs[i] * deltXs[i] + deltYs[i] * deltYs[i];
+            energy += length2;
+            if (measure)
+                record.maxForce = std::max(record.maxForce, length2);
+            deltXs[i] *= step;
+            deltYs[i] *= step;
+            length2 *= step * step;
+            if (length2 > maxStep * maxStep) {
+                double shrink = maxStep / std::sqrt(length2);
+                deltXs[i] *= shrink;
+                deltYs[i] *= shrink;
+                length2 = maxStep * maxStep;
+            }
+            xs[i] += deltXs[i];
+            ys[i] += deltYs[i];
+            maxDisplacement2 = std::max(maxDisplacement2, length2);
+            if (measure)
+                record.totalDisplacement += std::sqrt(length2);
+        }
+
+        if (energy < prevEnergy) {
+            if (++progress >= kHeatingStreak) {
+                progress = 0;
+                step = std::min(step / options.cooling, kMaxStep);
+                temperature = std::min(temperature / options.cooling, options.temperature);
+            }
+        }
+        else {
+            progress = 0;
+            step = std::max(step * options.cooling, 1.0);
+            temperature = std::max(temperature * options.cooling, minTemperature);
+        }
+        prevEnergy = energy;
+
+        ++stats.iterations;
+        stats.maxDisplacement = std::sqrt(maxDisplacement2) / scale;
+        stats.energy = energy;
+        stats.converged = options.tolerance > 0 && stats.maxDisplacement < options.tolerance;
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+        stats.seconds = secondsBefore + elapsed.count();
+        bool done = stats.converged ||
+            (options.seconds > 0 && stats.seconds >= options.seconds) ||
+            (options.iterations > 0 && stats.iterations >= size_t(options.iterations));
+
+        if (options.checkpoint && !done && stats.iterations % options.checkpoint->interval() == 0) {
+            SolverState solver;
+            solver.iterations = stats.iterations;
+            solver.seconds = stats.seconds;
+            solver.temperature = temperature;
+            solver.step = step;
+            solver.prevEnergy = prevEnergy;
+            solver.progress = progress;
+            options.checkpoint->save(solver, graph.edges.size(), xs.data(), ys.data(), order, size);
+        }
+
+        if (measure)
+            record.integrationSeconds = Lap(lapStart);
+
+        if (options.draw || done)
+            StorePositions(xs, ys, order, graph);
+        if (options.draw && options.onDraw)
+            options.onDraw(graph);
+        else if (options.draw)
+            DrawGraph(graph);
+
+        if (measure) {
+            record.drawSeconds = Lap(lapStart);
+            record.iteration = stats.iterations;
+            record.energy = energy;
+            record.maxForce = std::sqrt(record.maxForce);
+            record.temperature = temperature;
+            record.step = step;
+            std::size_t dropped = options.draw ? DroppedFrames() : droppedFrames;
+            record.droppedFrames = dropped - droppedFrames;
+            droppedFrames = dropped;
+            options.telemetry->record(record);
+        }
+        if (done) {
+            stats.graphIterations = stats.iterations;
+            return stats;
+        }
+    }
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+/*************************************************************************
+ * File: Layout.h
+ *
+ * The force-directed layout engine. ForceDirected() moves the nodes of a
+ * SimpleGraph under two kinds of forces: every pair of nodes repels, and the
+ * two endpoints of every edge attract.
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "SimpleGraph.h"
+#include "Adjacency.h"
+#include "QuadTree.h"
+#include "SpatialGrid.h"
+#include "ThreadPool.h"
+
+class CheckpointWriter;
+struct SolverState;
+class Telemetry;
+
+/**
+ * Type: LayoutOptions
+ * -----------------------------------------------------------------------
+ * Settings of a layout run.
+ *
+ * theta is the Barnes-Hut opening angle. With theta = 0 the repulsion is
+ * the exact all-pairs sum; with theta > 0 a group of far nodes whose cell
+ * is smaller than theta times its distance acts as a single node at its
+ * center of mass. Larger values are faster and less accurate; 0.5 to 1.0
+ * is the usual range.
+ *
+ * cutoff > 0 drops the repulsion between nodes farther apart than cutoff
+ * times the current mean edge length, and takes precedence over theta. The
+ * nodes are binned into a grid of cells that wide, so an iteration costs
+ * O(n) on an evenly spread layout. Only nearby nodes push each other apart,
+ * so unconnected parts of the graph no longer drift away from each other;
+ * 2 to 4 is a sensible range.
+ *
+ * The forces are computed on threads, each owning a range of nodes. The
+ * attraction runs over CSR neighbor lists (see Adjacency.h) built at the
+ * start of the run, so every node gathers the pull of its own neighbors and
+ * no thread writes to another's nodes. Only the all-pairs repulsion is
+ * summed into arrays per tile of rows, added up in tile order, and the
+ * tiles depend only on the number of nodes, so two runs give exactly the
+ * same layout whatever the number of threads.
+ *
+ * With reorder set, the nodes are renumbered in reverse Cuthill-McKee order
+ * for the run, so that neighbors sit close together in memory; graph.nodes
+ * keeps its own order.
+ *
+ * tolerance and temperature are fractions of the size of the layout, the
+ * diagonal of its bounding box, so they mean the same on small and large
+ * graphs. Every node moves by its force times a step size, but never
+ * farther than the temperature. Both follow an adaptive cooling schedule:
+ * they drop by the cooling factor whenever the energy (the sum of the
+ * squared forces) goes up, and grow back by the same factor after five
+ * iterations in a row that lowered it. The step never drops below 1, so the
+ * layout is never slower than plain force steps. The layout has converged
+ * once no node moved farther than the tolerance.
+ *
+ * With telemetry set, and GRAPHVIZ_TELEMETRY defined at build time, every
+ * iteration adds a record of its phase times and movement to it (see
+ * Telemetry.h). The multilevel scheme records every level's iterations.
+ *
+ * With checkpoint set, the run hands its positions and state to the
+ * writer every checkpoint->interval() iterations (see Checkpoint.h). With
+ * resume set, the run continues from that state instead of starting
+ * afresh: the graph must hold the checkpointed positions, and the
+ * iteration and time limits count the iterations and time before the
+ * checkpoint too. The other options should match the original run's.
+ *
+ * With fixedFrom > 0, the nodes from that index on never move. They still
+ * push and pull the others, which makes them a boundary for relaxing part
+ * of a layout (see Incremental.h).
+ *
+ * With draw set, every iteration hands the graph to onDraw instead of
+ * DrawGraph() if onDraw is given, so that a caller laying out part of a
+ * larger graph can draw the whole (see Components.h).
+ */
+struct LayoutOptions {
+    double seconds = 5;         // Wall-clock limit in seconds, 0 for none
+    int iterations = 0;         // Iteration limit, 0 for none
+    double tolerance = 1e-4;    // Converged once no node moves farther, 0 for never
+    double temperature = 0.1;   // Initial cap on a node's move, 0 for no cap
+    double cooling = 0.9;       // Step and temperature factor when the energy goes up
+    double theta = 0.0;         // Barnes-Hut opening angle, 0 for all pairs
+    double cutoff = 0.0;        // Repulsion radius in mean edge lengths, 0 for none
+    int threads = 0;            // Worker threads for the forces, 0 for one per core
+    bool reorder = true;        // Renumber the nodes for locality during the run
+    std::size_t fixedFrom = 0;  // First node that stays put, 0 for none
+    Telemetry* telemetry = nullptr; // Receives a record per iteration, if built in
+    CheckpointWriter* checkpoint = nullptr; // Saves the run now and then
+    const SolverState* resume = nullptr;    // Continues a checkpointed run
+    bool draw = true;           // Call DrawGraph after every iteration
+    std::function<void(SimpleGraph&)> onDraw; // Draws in place of DrawGraph, if set
+};
+
+/**
+ * Type: LayoutStats
+ * -----------------------------------------------------------------------
+ * What a layout run did: how many iterations it ran, how long it took,
+ * how far the nodes moved and the energy in the last iteration, and
+ * whether it stopped because the layout converged. The iterations count
+ * those of every level and component; graphIterations counts only those
+ * on the finest level, each component's weighted by its share of the
+ * nodes, so that it measures passes over the whole graph.
+ */
+struct LayoutStats {
+    std::size_t iterations = 0;
+    double graphIterations = 0.0;
+    double seconds = 0.0;
+    double maxDisplacement = 0.0;   // Relative to the layout size
+    double energy = 0.0;
+    bool converged = false;
+};
+
+/**
+ * Type: LayoutState
+ * -----------------------------------------------------------------------
+ * The working memory of ForceDirected(): positions, forces, per-tile
+ * force arrays, neighbor lists, the quadtree or grid, and the thread pool.
+ * A run sizes them once at its start, and its iterations only ever write
+ * into them, so an iteration allocates nothing once the tree and grid have
+ * grown to the size the layout needs (see Allocations.h for the check).
+ *
+ * Passing the same state to several runs also keeps the arrays and
+ * threads from one run to the next, which saves their allocation on runs
+ * that follow each other, such as the levels of the multilevel scheme or
+ * the relaxations of an incremental layout. A state holds no results,
+ * so any graph can be laid out with any state, but only by one run at a
+ * time.
+ */
+class LayoutState {
+public:
+    LayoutState() = default;
+    LayoutState(const LayoutState&) = delete;
+    LayoutState& operator=(const LayoutState&) = delete;
+
+private:
+    friend LayoutStats ForceDirected(SimpleGraph& graph, const LayoutOptions& options,
+                                     LayoutState& state);
+
+    Adjacency adjacency_;
+    Adjacency unordered_;                     // Before the renumbering
+    std::vector<std::uint32_t> order_;        // Node order[k] is at position k
+    std::vector<std::uint32_t> reorderScratch_;
+    std::vector<double> xs_, ys_;
+    std::vector<double> deltXs_, deltYs_;
+    std::vector<std::vector<double> > accXs_, accYs_;   // All-pairs sums per tile
+    std::vector<std::size_t> tileBounds_;
+    std::vector<double> threadRepulsion_, threadAttraction_;
+    QuadTree tree_;
+    SpatialGrid grid_;
+    std::unique_ptr<ThreadPool> pool_;
+    int poolThreads_ = 0;                     // The threads option pool_ was made for
+};
+
+/**
+ * Function: ForceDirected(SimpleGraph& graph, const LayoutOptions& options)
+ * -----------------------------------------------------------------------
+ * Runs the force-directed layout on the graph until the first of the
+ * limits in options is reached. At least one limit must be set. The
+ * second form works in the given state instead of a fresh one.
+ */
+LayoutStats ForceDirected(SimpleGraph& graph, const LayoutOptions& options);
+LayoutStats ForceDirected(SimpleGraph& graph, const LayoutOptions& options, LayoutState& state);
+
+/**
+ * Function: SecondsLeft(const LayoutOptions& options,
+ *                       std::chrono::steady_clock::time_point start,
+ *                       double reserve = 0)
+ * -----------------------------------------------------------------------
+ * Returns what is left of the time limit in options, counted from start,
+ * after keeping back reserve seconds, for drivers that split one limit
+ * between several runs. Returns 0, no limit, if options has none; once the
+ * time is up it returns a tiny limit instead, so a run still does one
+ * iteration.
+ */
+double SecondsLeft(const LayoutOptions& options, std::chrono::steady_clock::time_point start,
+                   double reserve = 0);
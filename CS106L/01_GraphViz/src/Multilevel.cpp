@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "Multilevel.h"
+#include "Adjacency.h"
+#include "Placement.h"
+
+using std::uint32_t;
+using std::vector;
+
+// A level whose matching keeps more than this fraction of the nodes ends
+// the coarsening
+const double kMinShrink = 0.75;
+
+// Matched pairs are pulled apart by this fraction of the mean edge length
+const double kJitter = 0.1;
+
+// Share of the time limit kept back for refining the input graph; the
+// coarser levels split the rest evenly
+const double kFinestLevelShare = 0.5;
+
+// One coarsening step: the edges of the finer graph, and for every one of
+// its nodes the node of the next coarser graph it was merged into
+struct Level {
+    size_t numNodes;
+    vector<Edge> edges;
+    vector<size_t> parent;
+};
+
+// Matches every node with its unmatched neighbor of lowest degree, visiting
+// the nodes in random order, and merges each pair into one coarse node.
+// Preferring low-degree partners keeps hubs from swallowing all their
+// neighbors in one step. Returns the number of coarse nodes.
+static size_t Match(size_t numNodes, const vector<Edge> &edges, std::mt19937 &rng,
+                    vector<size_t> &parent) {
+    Adjacency adjacency;
+    BuildAdjacency(numNodes, edges, adjacency);
+
+    vector<size_t> order(numNodes);
+    for (size_t i = 0; i < numNodes; ++i)
+        order[i] = i;
+    std::shuffle(order.begin(), order.end(), rng);
+
+    const size_t kUnmatched = size_t(-1);
+    parent.assign(numNodes, kUnmatched);
+    size_t numCoarse = 0;
+    for (size_t k = 0; k < numNodes; ++k) {
+        size_t u = order[k];
+        if (parent[u] != kUnmatched) continue;
+
+        size_t partner = kUnmatched;
+        for (uint32_t j = adjacency.offsets[u]; j < adjacency.offsets[u + 1]; ++j) {
+            size_t v = adjacency.neighbors[j];
+            if (parent[v] == kUnmatched &&
+                (partner == kUnmatched || adjacency.degree(v) < adjacency.degree(partner)))
+                partner = v;
+        }
+
+        parent[u] = numCoarse;
+        if (partner != kUnmatched)
+            parent[partner] = numCoarse;
+        ++numCoarse;
+    }
+    return numCoarse;
+}
+
+// The edges between the coarse nodes, without self-loops and duplicates
+static vector<Edge> CoarseEdges(const vector<Edge> &edges, const vector<size_t> &parent) {
+    vector<Edge> coarse;
+    coarse.reserve(edges.size());
+    for (size_t i = 0; i < edges.size(); ++i) {
+        size_t a = parent[edges[i].start], b = parent[edges[i].end];
+        if (a == b) continue;
+        Edge edge = {std::min(a, b), std::max(a, b)};
+        coarse.push_back(edge);
+    }
+    std::sort(coarse.begin(), coarse.end(), [](const Edge &l, const Edge &r) {
+        return l.start != r.start ? l.start < r.start : l.end < r.end;
+    });
+    coarse.erase(std::unique(coarse.begin(), coarse.end(), [](const Edge &l, const Edge &r) {
+        return l.start == r.start && l.end == r.end;
+    }), coarse.end());
+    return coarse;
+}
+
+// Places every fine node on its coarse node, plus a little jitter so that
+// the two nodes of a matched pair do not start on top of each other
+static void Interpolate(const SimpleGraph &coarse, const vector<size_t> &parent,
+                        std::mt19937 &rng, SimpleGraph &fine) {
+    double length = 0;
+    for (size_t i = 0; i < coarse.edges.size(); ++i) {
+        const Node &a = coarse.nodes[coarse.edges[i].start];
+        const Node &b = coarse.nodes[coarse.edges[i].end];
+        length += std::hypot(a.x - b.x, a.y - b.y);
+    }
+    length = coarse.edges.empty() ? 1.0 : length / coarse.edges.size();
+
+    std::uniform_real_distribution<double> jitter(-kJitter * length, kJitter * length);
+    fine.nodes.resize(parent.size());
+    for (size_t i = 0; i < parent.size(); ++i) {
+        fine.nodes[i].x = coarse.nodes[parent[i]].x + jitter(rng);
+        fine.nodes[i].y = coarse.nodes[parent[i]].y + jitter(rng);
+    }
+}
+
+// Run the multilevel scheme in a state of its own
+LayoutStats MultilevelLayout(SimpleGraph &graph, const LayoutOptions &options,
+                             const MultilevelOptions &multilevel) {
+    LayoutState state;
+    return MultilevelLayout(graph, options, multilevel, state);
+}
+
+// Coarsen down to the smallest level, lay it out from scratch, then
+// interpolate and refine back up to the input graph
+LayoutStats MultilevelLayout(SimpleGraph &graph, const LayoutOptions &options,
+                             const MultilevelOptions &multilevel, LayoutState &state) {
+    auto startTime = std::chrono::steady_clock::now();
+    std::mt19937 rng(multilevel.seed);
+
+    // Level 0 is the input graph. parents[k] maps the nodes of level k to
+    // those of level k + 1, whose edges are coarseEdges[k].
+    vector<size_t> sizes(1, graph.nodes.size());
+    vector<vector<size_t> > parents;
+    vector<vector<Edge> > coarseEdges;
+    while (sizes.back() > multilevel.coarsestNodes) {
+        const vector<Edge> &edges = coarseEdges.empty() ? graph.edges : coarseEdges.back();
+        vector<size_t> parent;
+        size_t numCoarse = Match(sizes.back(), edges, rng, parent);
+        if (numCoarse > kMinShrink * sizes.back()) break;
+
+        vector<Edge> coarse = CoarseEdges(edges, parent);
+        coarseEdges.push_back(std::move(coarse));
+        parents.push_back(std::move(parent));
+        sizes.push_back(numCoarse);
+    }
+    if (parents.empty()) {
+        LayoutOptions single = options;
+        single.seconds = SecondsLeft(options, startTime);
+        return ForceDirected(graph, single, state);
+    }
+
+    // Every coarse level gets an even share of the time left once the
+    // finest level's share is kept back, and the finest level what is left
+    double reserve = kFinestLevelShare * options.seconds;
+
+    // The coarsest level starts on the unit circle, like a loaded graph
+    SimpleGraph coarse, fine;
+    size_t numCoarse = sizes.back();
+    coarse.nodes.resize(numCoarse);
+    coarse.edges = coarseEdges.back();
+    PlaceOnCircle(coarse, 0);
+
+    // Every level runs in the same state, which grows with the levels
+    LayoutOptions coarsest = options;
+    coarsest.draw = false;
+    coarsest.seconds = SecondsLeft(options, startTime, reserve) / parents.size();
+    LayoutStats stats = ForceDirected(coarse, coarsest, state);
+    size_t iterations = stats.iterations;
+
+    LayoutOptions refine = options;
+    refine.temperature = multilevel.refineTemperature;
+    if (refine.iterations <= 0 || refine.iterations > multilevel.refineIterations)
+        refine.iterations = multilevel.refineIterations;
+    for (size_t k = parents.size(); k-- > 0; ) {
+        SimpleGraph &target = k == 0 ? graph : fine;
+        Interpolate(coarse, parents[k], rng, target);
+        if (k > 0)
+            target.edges = coarseEdges[k - 1];
+
+        refine.draw = options.draw && k == 0;
+        refine.seconds = k == 0 ? SecondsLeft(options, startTime)
+                                : SecondsLeft(options, startTime, reserve) / k;
+        stats = ForceDirected(target, refine, state);
+        iterations += stats.iterations;
+
+        coarse.nodes.swap(fine.nodes);
+        coarse.edges.swap(fine.edges);
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+    stats.iterations = iterations;
+    stats.seconds = elapsed.count();
+    return stats;
+}
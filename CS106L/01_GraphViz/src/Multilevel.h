@@ -0,0 +1,55 @@
+#pragma once
+
+/*************************************************************************
+ * File: Multilevel.h
+ *
+ * A multilevel driver for the force-directed layout. The graph is
+ * coarsened again and again by collapsing the edges of a maximal matching,
+ * the small coarsest graph is laid out from scratch, and the positions are
+ * then carried back down one level at a time, where a few iterations of
+ * ForceDirected() smooth out the new detail. The coarse levels fix the
+ * global shape cheaply, so the expensive full-size graph only needs local
+ * refinement.
+ */
+
+#include <cstddef>
+
+#include "SimpleGraph.h"
+#include "Layout.h"
+
+/**
+ * Type: MultilevelOptions
+ * -----------------------------------------------------------------------
+ * Settings of the coarsening and refinement on top of the LayoutOptions.
+ *
+ * Coarsening stops once a level has at most coarsestNodes nodes, or when a
+ * matching no longer removes at least a quarter of the nodes, as happens
+ * around the center of a star. Every finer level, the input graph included,
+ * is refined with at most refineIterations iterations, starting at
+ * refineTemperature, since it only has to move its nodes a short way. The
+ * result is then usually close to, but not at, a converged layout.
+ */
+struct MultilevelOptions {
+    std::size_t coarsestNodes = 50;
+    int refineIterations = 100;
+    double refineTemperature = 0.01;
+    unsigned seed = 0;                 // Seed of the matching and the jitter
+};
+
+/**
+ * Function: MultilevelLayout(SimpleGraph& graph, const LayoutOptions& options,
+ *                            const MultilevelOptions& multilevel)
+ * -----------------------------------------------------------------------
+ * Lays out the graph with the multilevel scheme, ignoring its current node
+ * positions. The time limit in options covers the whole scheme: half of it
+ * is kept for refining the input graph, the coarser levels split the rest,
+ * and every level also gets whatever the levels before it left unused. The
+ * other options apply to every level; only the last one is drawn. Returns
+ * the stats of the last level, with the iterations and time of all levels
+ * added up. The second form runs every level in the given state (see
+ * LayoutState in Layout.h) instead of a fresh one.
+ */
+LayoutStats MultilevelLayout(SimpleGraph& graph, const LayoutOptions& options,
+                             const MultilevelOptions& multilevel = MultilevelOptions());
+LayoutStats MultilevelLayout(SimpleGraph& graph, const LayoutOptions& options,
+                             const MultilevelOptions& multilevel, LayoutState& state);
@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "Placement.h"
+#include "Adjacency.h"
+
+using std::uint32_t;
+using std::vector;
+
+// Constant number
+const double kPi = 3.14159265358979323;
+
+// Power iterations of the spectral placement
+const int kSpectralIterations = 300;
+
+// Random offset added to the spectral coordinates, in node spacings.
+// Symmetric nodes such as the leaves under one parent get the same entries
+// in every eigenvector, and coincident nodes would push each other apart
+// with an infinite force.
+const double kSpectralJitter = 0.1;
+
+// Put the nodes evenly on the unit circle
+void PlaceOnCircle(SimpleGraph &graph, unsigned) {
+    size_t n = graph.nodes.size();
+    for (size_t i = 0; i < n; ++i) {
+        graph.nodes[i].x = std::cos(2 * kPi * i / n);
+        graph.nodes[i].y = std::sin(2 * kPi * i / n);
+    }
+}
+
+void PlaceRandomly(SimpleGraph &graph, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    for (size_t i = 0; i < graph.nodes.size(); ++i) {
+        graph.nodes[i].x = uniform(rng);
+        graph.nodes[i].y = uniform(rng);
+    }
+}
+
+// Breadth-first search from source over the unvisited nodes, appending them
+// to order and recording their depth. Returns the last node reached, one of
+// the farthest from the source.
+static uint32_t Bfs(const Adjacency &adjacency, uint32_t source, vector<uint32_t> &depth,
+                    vector<uint32_t> &order) {
+    const uint32_t kUnvisited = uint32_t(-1);
+    size_t head = order.size();
+    order.push_back(source);
+    depth[source] = 0;
+    for (; head < order.size(); ++head) {
+        uint32_t u = order[head];
+        for (uint32_t k = adjacency.offsets[u]; k < adjacency.offsets[u + 1]; ++k) {
+            uint32_t v = adjacency.neighbors[k];
+            if (depth[v] != kUnvisited) continue;
+            depth[v] = depth[u] + 1;
+            order.push_back(v);
+        }
+    }
+    return order.back();
+}
+
+// Find a central node of every component, then lay its BFS layers out on
+// circles
+void PlaceByBfsLayers(SimpleGraph &graph, unsigned) {
+    const uint32_t kUnvisited = uint32_t(-1);
+    size_t n = graph.nodes.size();
+    Adjacency adjacency;
+    BuildAdjacency(n, graph.edges, adjacency);
+
+    vector<uint32_t> depth(n, kUnvisited), sweep(n, kUnvisited), order;
+    vector<uint32_t> component;
+    double offsetX = 0;
+    for (uint32_t s = 0; s < n; ++s) {
+        if (depth[s] != kUnvisited) continue;
+
+        // Two sweeps: the farthest node from s, then the farthest from that,
+        // whose path back is walked halfway to find the center
+        component.clear();
+        uint32_t a = Bfs(adjacency, s, sweep, component);
+        for (size_t i = 0; i < component.size(); ++i)
+            sweep[component[i]] = kUnvisited;
+        component.clear();
+        uint32_t b = Bfs(adjacency, a, sweep, component);
+        uint32_t center = b;
+        for (uint32_t steps = sweep[b] / 2; steps > 0; --steps) {
+            for (uint32_t k = adjacency.offsets[center]; k < adjacency.offsets[center + 1]; ++k) {
+                uint32_t v = adjacency.neighbors[k];
+                if (sweep[v] + 1 == sweep[center]) {
+                    center = v;
+                    break;
+                }
+            }
+        }
+
+        size_t first = order.size();
+        Bfs(adjacency, center, depth, order);
+
+        // Count the layers, then spread each one around its circle
+        uint32_t layers = depth[order.back()] + 1;
+        vector<size_t> layerSize(layers, 0), placed(layers, 0);
+        for (size_t i = first; i < order.size(); ++i)
+            ++layerSize[depth[order[i]]];
+        double radius = layers - 1;
+        offsetX += radius;
+        for (size_t i = first; i < order.size(); ++i) {
+            uint32_t u = order[i], d = depth[u];
+            double angle = 2 * kPi * placed[d]++ / layerSize[d];
+            graph.nodes[u].x = offsetX + d * std::cos(angle);
+            graph.nodes[u].y = d * std::sin(angle);
+        }
+        offsetX += radius + 1;
+    }
+}
+
+// D-orthogonalize x against the columns in basis, then scale it to unit length
+static void Orthonormalize(vector<double> &x, const vector<vector<double> > &basis,
+                           const vector<double> &degree) {
+    for (size_t b = 0; b < basis.size(); ++b) {
+        double dot = 0, norm = 0;
+        for (size_t i = 0; i < x.size(); ++i) {
+            dot += x[i] * degree[i] * basis[b][i];
+            norm += basis[b][i] * degree[i] * basis[b][i];
+        }
+        for (size_t i = 0; i < x.size(); ++i)
+            x[i] -= dot / norm * basis[b][i];
+    }
+    double length = 0;
+    for (size_t i = 0; i < x.size(); ++i)
+        length += x[i] * x[i];
+    length = std::sqrt(length);
+    if (length > 0) {
+        for (size_t i = 0; i < x.size(); ++i)
+            x[i] /= length;
+    }
+}
+
+// Power iteration for the second and third eigenvectors, one at a time
+void PlaceSpectrally(SimpleGraph &graph, unsigned seed) {
+    size_t n = graph.nodes.size();
+    Adjacency adjacency;
+    BuildAdjacency(n, graph.edges, adjacency);
+
+    // Isolated nodes act as if they had a self-loop, so that they stay put
+    vector<double> degree(n);
+    for (size_t i = 0; i < n; ++i)
+        degree[i] = std::max<uint32_t>(adjacency.degree(i), 1);
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    vector<vector<double> > basis(1, vector<double>(n, 1.0));
+    vector<double> next(n);
+    for (int axis = 0; axis < 2; ++axis) {
+        vector<double> x(n);
+        for (size_t i = 0; i < n; ++i)
+            x[i] = uniform(rng);
+        Orthonormalize(x, basis, degree);
+
+        for (int iteration = 0; iteration < kSpectralIterations; ++iteration) {
+            for (size_t i = 0; i < n; ++i) {
+                double sum = adjacency.degree(i) == 0 ? x[i] : 0.0;
+                for (uint32_t k = adjacency.offsets[i]; k < adjacency.offsets[i + 1]; ++k)
+                    sum += x[adjacency.neighbors[k]];
+                next[i] = 0.5 * (x[i] + sum / degree[i]);
+            }
+            x.swap(next);
+            Orthonormalize(x, basis, degree);
+        }
+        basis.push_back(x);
+    }
+
+    // Unit-length eigenvectors have entries around 1 / sqrt(n); scale them
+    // to the size of the circle placement, then pull apart coincident nodes
+    double scale = std::sqrt(double(n));
+    double jitter = kSpectralJitter / scale;
+    for (size_t i = 0; i < n; ++i) {
+        graph.nodes[i].x = scale * basis[1][i] + jitter * uniform(rng);
+        graph.nodes[i].y = scale * basis[2][i] + jitter * uniform(rng);
+    }
+}
+
+PlacementStrategy FindPlacement(const std::string &name) {
+    if (name == "circle") return PlaceOnCircle;
+    if (name == "random") return PlaceRandomly;
+    if (name == "bfs") return PlaceByBfsLayers;
+    if (name == "spectral") return PlaceSpectrally;
+    return NULL;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+/*************************************************************************
+ * File: Placement.h
+ *
+ * Initial placements for the layout. ForceDirected() only moves nodes
+ * downhill from where they start, so a start that already has neighbors
+ * near each other saves most of the iterations spent untangling.
+ *
+ * Every strategy moves the nodes of a graph that already has its nodes and
+ * edges, and is a plain function, so callers can pick one by name or pass
+ * their own.
+ */
+
+#include <string>
+
+#include "SimpleGraph.h"
+
+/**
+ * Type: PlacementStrategy
+ * -----------------------------------------------------------------------
+ * A function that places every node of the graph. seed makes randomized
+ * strategies repeatable; the others ignore it.
+ */
+typedef void (*PlacementStrategy)(SimpleGraph& graph, unsigned seed);
+
+/**
+ * Function: PlaceOnCircle(SimpleGraph& graph, unsigned seed)
+ * -----------------------------------------------------------------------
+ * Puts the nodes evenly on the unit circle in index order, the placement
+ * LoadGraph() uses.
+ */
+void PlaceOnCircle(SimpleGraph& graph, unsigned seed);
+
+/**
+ * Function: PlaceRandomly(SimpleGraph& graph, unsigned seed)
+ * -----------------------------------------------------------------------
+ * Puts the nodes uniformly at random in the square [-1, 1] x [-1, 1].
+ */
+void PlaceRandomly(SimpleGraph& graph, unsigned seed);
+
+/**
+ * Function: PlaceByBfsLayers(SimpleGraph& graph, unsigned seed)
+ * -----------------------------------------------------------------------
+ * Puts every connected component on concentric circles around a central
+ * node: the nodes at distance d from it go evenly on the circle of radius
+ * d, in breadth-first order, so that siblings stay next to each other. The
+ * center is the middle of a long shortest path, found by two breadth-first
+ * sweeps. Components are lined up side by side.
+ */
+void PlaceByBfsLayers(SimpleGraph& graph, unsigned seed);
+
+/**
+ * Function: PlaceSpectrally(SimpleGraph& graph, unsigned seed)
+ * -----------------------------------------------------------------------
+ * Uses the two smoothest non-constant eigenvectors of the graph as the x
+ * and y coordinates, approximated by a few hundred power iterations of the
+ * random-walk matrix (I + D^-1 A) / 2 from random vectors, keeping them
+ * degree-orthogonal to the constant vector and to each other (Koren's
+ * method). Neighbors end up close because the eigenvectors vary slowly
+ * along the edges.
+ */
+void PlaceSpectrally(SimpleGraph& graph, unsigned seed);
+
+/**
+ * Function: FindPlacement(const std::string& name)
+ * -----------------------------------------------------------------------
+ * Returns the strategy called "circle", "random", "bfs" or "spectral", or
+ * NULL for any other name.
+ */
+PlacementStrategy FindPlacement(const std::string& name);
@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <cmath>
+
+#include "QuadTree.h"
+
+// Cells with at most this many nodes are not split further
+const std::size_t kLeafSize = 1;
+
+// Coincident nodes cannot be separated, so splitting stops at this depth
+const int kMaxDepth = 48;
+
+// Build the tree over the bounding square of the nodes
+void QuadTree::build(const double *x, const double *y, std::size_t n) {
+    cells_.clear();
+    order_.resize(n);
+    if (n == 0) return;
+
+    double minX = x[0], maxX = x[0];
+    double minY = y[0], maxY = y[0];
+    for (std::size_t i = 0; i < n; ++i) {
+        order_[i] = i;
+        minX = std::min(minX, x[i]);
+        maxX = std::max(maxX, x[i]);
+        minY = std::min(minY, y[i]);
+        maxY = std::max(maxY, y[i]);
+    }
+
+    double size = std::max(maxX - minX, maxY - minY);
+    buildRe(x, y, 0, n, minX, minY, size, 0);
+}
+
+// Build the cell for order_[begin, end) covering the square at (x0, y0)
+int QuadTree::buildRe(const double *x, const double *y, std::size_t begin, std::size_t end,
+                      double x0, double y0, double size, int depth) {
+    int index = cells_.size();
+    cells_.push_back(Cell());
+
+    Cell cell;
+    cell.cx = cell.cy = 0;
+    for (std::size_t i = begin; i < end; ++i) {
+        cell.cx += x[order_[i]];
+        cell.cy += y[order_[i]];
+    }
+    cell.mass = end - begin;
+    cell.cx /= cell.mass;
+    cell.cy /= cell.mass;
+    cell.x0 = x0;
+    cell.y0 = y0;
+    cell.size = size;
+    cell.begin = begin;
+    cell.end = end;
+    cell.leaf = end - begin <= kLeafSize || depth >= kMaxDepth;
+    std::fill(cell.child, cell.child + 4, -1);
+
+    if (!cell.leaf) {
+        // Split into quadrants: bottom-left, bottom-right, top-left, top-right
+        double half = size / 2;
+        double midX = x0 + half, midY = y0 + half;
+        auto first = order_.begin();
+        std::size_t bounds[5];
+        bounds[0] = begin;
+        bounds[4] = end;
+        bounds[2] = std::partition(first + begin, first + end,
+                                   [&](std::size_t n) { return y[n] < midY; }) - first;
+        bounds[1] = std::partition(first + begin, first + bounds[2],
+                                   [&](std::size_t n) { return x[n] < midX; }) - first;
+        bounds[3] = std::partition(first + bounds[2], first + end,
+                                   [&](std::size_t n) { return x[n] < midX; }) - first;
+
+        for (int q = 0; q < 4; ++q) {
+            if (bounds[q] == bounds[q + 1]) continue;
+            double qx = (q & 1) ? midX : x0;
+            double qy = (q & 2) ? midY : y0;
+            cell.child[q] = buildRe(x, y, bounds[q], bounds[q + 1], qx, qy, half, depth + 1);
+        }
+    }
+
+    cells_[index] = cell;
+    return index;
+}
+
+// Walk the tree, opening only the cells that are too close to approximate.
+// A cell around node i is always opened: its center of mass can lie far
+// from i, but the cell holds i's own mass and nodes right next to it.
+void QuadTree::repulsion(const double *x, const double *y, std::size_t i, double theta,
+                         double kRepel, double &fx, double &fy) const {
+    if (cells_.empty()) return;
+
+    const double xi = x[i], yi = y[i];
+    const double theta2 = theta * theta;
+    int stack[4 * kMaxDepth + 4];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        const Cell &cell = cells_[stack[--top]];
+        if (cell.leaf) {
+            for (std::size_t k = cell.begin; k < cell.end; ++k) {
+                std::size_t j = order_[k];
+                if (j == i) continue;
+                double dx = xi - x[j];
+                double dy = yi - y[j];
+                double f = kRepel / (dx * dx + dy * dy);
+                fx += f * dx;
+                fy += f * dy;
+            }
+            continue;
+        }
+
+        double dx = xi - cell.cx;
+        double dy = yi - cell.cy;
+        double d2 = dx * dx + dy * dy;
+        bool holdsNode = xi >= cell.x0 && xi <= cell.x0 + cell.size &&
+                         yi >= cell.y0 && yi <= cell.y0 + cell.size;
+        if (!holdsNode && cell.size * cell.size < theta2 * d2) {
+            double f = kRepel * cell.mass / d2;
+            fx += f * dx;
+            fy += f * dy;
+        }
+        else {
+            for (int q = 0; q < 4; ++q)
+                if (cell.child[q] >= 0) stack[top++] = cell.child[q];
+        }
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+/*************************************************************************
+ * File: QuadTree.h
+ *
+ * A quadtree over the nodes of a graph, used for the Barnes-Hut
+ * approximation of the repulsive forces. Every cell of the tree knows how
+ * many nodes it holds and their center of mass, so a cell that is far
+ * enough from a node can push it away as if it were a single heavy node.
+ * That replaces the O(n^2) all-pairs sum with an O(n log n) one.
+ */
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Type: QuadTree
+ * -----------------------------------------------------------------------
+ * build() indexes the current node positions, given as arrays x[] and y[];
+ * the tree must be rebuilt whenever the nodes move. repulsion() then returns
+ * the approximate repulsive force on one node.
+ */
+class QuadTree {
+public:
+    void build(const double* x, const double* y, std::size_t n);
+
+    /* Adds to (fx, fy) the force that all other nodes exert on node i, with
+     * the pairwise force kRepel / d along the line between the nodes. Cells
+     * whose size is below theta times their distance are not opened, except
+     * those whose square holds the node itself, which always are.
+     */
+    void repulsion(const double* x, const double* y, std::size_t i, double theta,
+                   double kRepel, double& fx, double& fy) const;
+
+private:
+    struct Cell {
+        double cx, cy;            // Center of mass
+        double mass;              // Number of nodes in the cell
+        double x0, y0;            // Bottom-left corner of the square
+        double size;              // Side length of the square
+        int child[4];             // Sub-cells, -1 when missing
+        std::size_t begin, end;   // The cell's nodes in order_
+        bool leaf;
+    };
+
+    std::vector<Cell> cells_;
+    std::vector<std::size_t> order_;   // Node indices, grouped by cell
+
+    int buildRe(const double* x, const double* y, std::size_t begin, std::size_t end,
+                double x0, double y0, double size, int depth);
+};
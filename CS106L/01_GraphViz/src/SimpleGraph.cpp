@@ -1,12 +1,13 @@
 #include <iostream>
+#include <string>
 
 #include <QtGui>
 #include <QWidget>
 #include <QApplication>
 #include <algorithm>
+#include <cmath>
 #include <QCoreApplication>
 #include <QObject>
-#include <QSemaphore>
 
 #include "SimpleGraph.h"
 #undef main
@@ -25,88 +26,247 @@ const QString kCircleFill = "#92FCFF";
 const QString kCircleLine = "#0d0d0d";
 const QString kLineColor = "#606060";
 
+// Level of detail: up to kMaxCircleNodes nodes in the window are drawn as
+// circles and up to kMaxDetailNodes as dots. Past that, or past
+// kMaxDetailEdges edges in the window, the edges are left out and the nodes
+// are binned into tiles of kTileSize pixels, shaded by how many they hold,
+// so the cost of drawing never grows past the size of the window.
+const size_t kMaxCircleNodes = 2000;
+const size_t kMaxDetailNodes = 50000;
+const size_t kMaxDetailEdges = 100000;
+const int kTileSize = 4;
+const int kDotSize = 3;
+const double kZoomStep = 1.25;
 
 
-/* global semaphore to ensure only one update call at a time.
- * Prevents overload of update calls */
-QSemaphore semaphore;
-
 
 void InitGraphVisualizer(SimpleGraph & userGraph) {
     MyWidget& g = MyWidget::getInstance();
-    QObject::connect(&userGraph, SIGNAL(graphUpdated(SimpleGraph)),
-                     &g, SLOT(repaint()));
+    QObject::connect(&userGraph, SIGNAL(graphUpdated()),
+                     &g, SLOT(update()));
 }
 
+/* Shows the cached picture, drawing it again only if a new frame came in,
+ * the view changed or the window was resized. */
 void MyWidget::paintEvent(QPaintEvent *event) {
     Q_UNUSED(event);
+    // Clear the flag first, so a frame published from here on queues
+    // another paint
+    paintPending.store(false);
+    if (frames.update() || !cacheValid || cache.size() != size())
+        render();
+
     QPainter painter(this);
-    painter.fillRect(rect(), QColor(kBackgroundColor));
-    if (!userGraph.nodes.empty()) {
-        SimpleGraph copy;
-        copy.nodes = userGraph.nodes;
-        copy.edges = userGraph.edges;
-        auto getX = [](const Node& a, const Node& b) {return a.x < b.x;};
-        double maxX = std::max_element(copy.nodes.begin(), copy.nodes.end(), getX)->x;
-        double minX = std::min_element(copy.nodes.begin(), copy.nodes.end(), getX)->x;
-
-        auto getY = [](const Node& a, const Node& b) { return a.y < b.y;};
-        double maxY = std::max_element(copy.nodes.begin(), copy.nodes.end(), getY)->y;
-        double minY = std::min_element(copy.nodes.begin(), copy.nodes.end(), getY)->y;
-
-        auto scale = [maxX, maxY, minX, minY](const Node& a) -> Node {
-            return {(a.x - minX) *(kWindowWidth - kCircleDiameter) / (-minX + maxX) + kCircleRadius,
-                    (a.y - minY) *(kWindowHeight - kCircleDiameter) / (-minY + maxY) + kCircleRadius};
-        };
-
-        std::transform(copy.nodes.begin(), copy.nodes.end(), copy.nodes.begin(), scale);
-
-        painter.setPen(QColor(kLineColor));
-        for (Edge & e : copy.edges) {
-            Node start = copy.nodes[e.start];
-            Node end = copy.nodes[e.end];
-            painter.drawLine(start.x, start.y, end.x, end.y);
+    painter.drawPixmap(0, 0, cache);
+}
+
+/* Bits for the sides of the view a point lies beyond. A line whose ends
+ * share a bit lies entirely off that side. */
+static int OutCode(const QPointF &p, const QRectF &view) {
+    int code = 0;
+    if (p.x() < view.left()) code |= 1;
+    else if (p.x() > view.right()) code |= 2;
+    if (p.y() < view.top()) code |= 4;
+    else if (p.y() > view.bottom()) code |= 8;
+    return code;
+}
+
+/* Draws the front frame into the cache: the edges in one batch and the
+ * nodes as circles or dots, leaving out whatever lies outside the window,
+ * or density tiles when there is too much to draw. */
+void MyWidget::render() {
+    if (cache.size() != size())
+        cache = QPixmap(size());
+    cacheValid = true;
+    QPainter painter(&cache);
+    painter.fillRect(cache.rect(), QColor(kBackgroundColor));
+
+    const Frame& frame = frames.front();
+    if (frame.nodes.empty()) return;
+
+    // Fit the layout to the window, then apply the zoom and pan
+    double spanX = frame.maxX > frame.minX ? frame.maxX - frame.minX : 1.0;
+    double spanY = frame.maxY > frame.minY ? frame.maxY - frame.minY : 1.0;
+    double scaleX = (kWindowWidth - kCircleDiameter) / spanX * zoom;
+    double scaleY = (kWindowHeight - kCircleDiameter) / spanY * zoom;
+    double offsetX = kCircleRadius * zoom + pan.x();
+    double offsetY = kCircleRadius * zoom + pan.y();
+
+    QRectF view = QRectF(cache.rect()).adjusted(-kCircleRadius, -kCircleRadius,
+                                                kCircleRadius, kCircleRadius);
+    points.resize(frame.nodes.size());
+    visible.clear();
+    for (size_t i = 0; i < frame.nodes.size(); ++i) {
+        points[i] = QPointF((frame.nodes[i].x - frame.minX) * scaleX + offsetX,
+                            (frame.nodes[i].y - frame.minY) * scaleY + offsetY);
+        if (view.contains(points[i]) && visible.size() <= kMaxDetailNodes)
+            visible.push_back(points[i]);
+    }
+
+    lines.clear();
+    if (visible.size() <= kMaxDetailNodes) {
+        for (const Edge & e : *frame.edges) {
+            // An edge list out of step with the nodes must not read past them
+            if (e.start >= points.size() || e.end >= points.size()) continue;
+            const QPointF &a = points[e.start], &b = points[e.end];
+            if (OutCode(a, view) & OutCode(b, view)) continue;
+            lines.push_back(QLineF(a, b));
+            if (lines.size() > kMaxDetailEdges) break;
         }
+    }
+
+    if (visible.size() > kMaxDetailNodes || lines.size() > kMaxDetailEdges) {
+        int columns = (cache.width() + kTileSize - 1) / kTileSize;
+        int rows = (cache.height() + kTileSize - 1) / kTileSize;
+        tiles.assign(columns * rows, 0);
+        int most = 0;
+        for (const QPointF & p : points) {
+            if (p.x() < 0 || p.y() < 0 || p.x() >= cache.width() || p.y() >= cache.height())
+                continue;
+            int &count = tiles[int(p.y()) / kTileSize * columns + int(p.x()) / kTileSize];
+            most = std::max(most, ++count);
+        }
+
+        // Shade on a log scale, so that sparse tiles still show
+        QColor color(kCircleFill);
+        for (int k = 0; k < columns * rows; ++k) {
+            if (tiles[k] == 0) continue;
+            color.setAlphaF(0.2 + 0.8 * std::log1p(tiles[k]) / std::log1p(most));
+            painter.fillRect(QRectF(k % columns * kTileSize, k / columns * kTileSize,
+                                    kTileSize, kTileSize), color);
+        }
+        return;
+    }
+
+    painter.setPen(QColor(kLineColor));
+    painter.drawLines(lines.data(), int(lines.size()));
 
+    if (visible.size() <= kMaxCircleNodes) {
         painter.setPen(QColor(kCircleLine));
         painter.setBrush(QColor(kCircleFill));
-        for (Node & n : copy.nodes) {
-            painter.drawEllipse(n.x - kCircleRadius, n.y - kCircleRadius, kCircleDiameter, kCircleDiameter);
+        for (const QPointF & p : visible) {
+            painter.drawEllipse(p, kCircleRadius, kCircleRadius);
         }
     }
+    else {
+        painter.setPen(QPen(QColor(kCircleFill), kDotSize));
+        painter.drawPoints(visible.data(), int(visible.size()));
+    }
+}
+
+/* The wheel zooms about the cursor, keeping the point under it in place. */
+void MyWidget::wheelEvent(QWheelEvent *event) {
+    double factor = std::pow(kZoomStep, event->angleDelta().y() / 120.0);
+    QPointF cursor = event->position();
+    pan = cursor - (cursor - pan) * factor;
+    zoom *= factor;
+    cacheValid = false;
+    update();
+}
+
+/* Dragging with any button pans; a double click resets the view. */
+void MyWidget::mousePressEvent(QMouseEvent *event) {
+    dragStart = event->pos();
+    dragging = true;
+}
 
-    //last_run = QTime::currentTime();
-    semaphore.release();
+void MyWidget::mouseMoveEvent(QMouseEvent *event) {
+    if (!dragging) return;
+    pan += event->pos() - dragStart;
+    dragStart = event->pos();
+    cacheValid = false;
+    update();
+}
+
+void MyWidget::mouseReleaseEvent(QMouseEvent *event) {
+    Q_UNUSED(event);
+    dragging = false;
 }
 
+void MyWidget::mouseDoubleClickEvent(QMouseEvent *event) {
+    Q_UNUSED(event);
+    zoom = 1.0;
+    pan = QPointF();
+    cacheValid = false;
+    update();
+}
+
+int _userMain(int argc, char **argv);
+
 class WorkerThread : public QThread {
+public:
+    WorkerThread(int argc, char **argv) : argc_(argc), argv_(argv) {}
+
+private:
     void run() {
-        int _userMain();
-        _userMain();
+        _userMain(argc_, argv_);
 
     }
+
+    int argc_;
+    char **argv_;
 };
 
 int main(int argc, char **argv) {
+    // With --headless, --batch, a benchmark, a check or --convert the
+    // user's main runs alone, without any window
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--headless" || arg == "--batch" || arg.compare(0, 11, "--benchmark") == 0 ||
+            arg.compare(0, 8, "--check-") == 0 || arg == "--convert")
+            return _userMain(argc, argv);
+    }
+
     QApplication app(argc, argv);
     MyWidget & myWidget = MyWidget::getInstance();
 //    myWidget.resize(600, 600);
     myWidget.resize(kWindowWidth, kWindowHeight);
     myWidget.show();
-    qRegisterMetaType<SimpleGraph>(); //allows use of SimpleGraph in signals/slots
-    WorkerThread x;
+    WorkerThread x(argc, argv);
     x.start();
     return app.exec();
 }
 
+/* Publishes the node positions without waiting for the window. The edges
+ * are copied only when they differ from the last frame's: another graph,
+ * another edge count, a reallocated edge array or a new edge version. */
 void SimpleGraph::drawGraph(SimpleGraph &graph) {
-    if (!semaphore.tryAcquire()) return;
     MyWidget& m = MyWidget::getInstance();
-    m.userGraph.nodes = graph.nodes;
-    m.userGraph.edges = graph.edges;
-    emit graphUpdated(graph);
+    if (!m.sharedEdges || m.edgesSource != &graph || m.edgesData != graph.edges.data() ||
+        m.sharedEdges->size() != graph.edges.size() || m.edgesVersion != graph.edgeVersion) {
+        m.sharedEdges = std::make_shared<const std::vector<Edge> >(graph.edges);
+        m.edgesSource = &graph;
+        m.edgesData = graph.edges.data();
+        m.edgesVersion = graph.edgeVersion;
+    }
+
+    Frame& frame = m.frames.back();
+    frame.nodes.assign(graph.nodes.begin(), graph.nodes.end());
+    frame.edges = m.sharedEdges;
+    frame.minX = frame.minY = 0;
+    frame.maxX = frame.maxY = 0;
+    if (!frame.nodes.empty()) {
+        frame.minX = frame.maxX = frame.nodes[0].x;
+        frame.minY = frame.maxY = frame.nodes[0].y;
+    }
+    for (const Node & n : frame.nodes) {
+        frame.minX = std::min(frame.minX, n.x);
+        frame.maxX = std::max(frame.maxX, n.x);
+        frame.minY = std::min(frame.minY, n.y);
+        frame.maxY = std::max(frame.maxY, n.y);
+    }
+    if (m.frames.publish())
+        ++m.droppedFrames;
+
+    // One queued paint at a time, it will show the latest frame anyway
+    if (!m.paintPending.exchange(true))
+        emit graphUpdated();
 }
 
 void DrawGraph(SimpleGraph& userGraph) {
     userGraph.drawGraph(userGraph);
 }
+
+std::size_t DroppedFrames() {
+    return MyWidget::getInstance().droppedFrames;
+}
@@ -11,9 +11,17 @@
 
 #include <vector>
 #include <cstddef>
+#include <memory>
+#include <atomic>
 #include <QObject>
 #include <QWidget>
 #include <QTime>
+#include <QPointF>
+#include <QPoint>
+#include <QLineF>
+#include <QPixmap>
+
+#include "TripleBuffer.h"
 
 /**
  * Type: Node
@@ -40,12 +48,16 @@ struct Edge {
 /**
  * Type: SimpleGraph
  * -----------------------------------------------------------------------
- * A type representing a simple graph of nodes and edges.
+ * A type representing a simple graph of nodes and edges. Code that
+ * changes the edges in place must increment edgeVersion, so that
+ * DrawGraph() hands the window the new edges rather than the ones it
+ * already has.
  */
 
 struct SimpleGraph {
     std::vector<Node> nodes;
     std::vector<Edge> edges;
+    std::size_t edgeVersion = 0;
 };
 
 /**
@@ -57,6 +69,16 @@ struct SimpleGraph {
 void DrawGraph(SimpleGraph& userGraph);
 void InitGraphVisualizer(SimpleGraph& userGraph);
 
+/**
+ * Function: DroppedFrames()
+ * -----------------------------------------------------------------------
+ * Returns how many of the frames passed to DrawGraph() so far were
+ * replaced by a newer one before the window could show them. Only call it
+ * once the window is up.
+ */
+
+std::size_t DroppedFrames();
+
 
 
 
@@ -74,19 +96,28 @@ class SimpleGraph : public QObject {
 
   public:
     SimpleGraph(){}
-    SimpleGraph(const SimpleGraph& other):QObject(), nodes(other.nodes), edges(other.edges){}
+    SimpleGraph(const SimpleGraph& other):QObject(), nodes(other.nodes), edges(other.edges),
+        edgeVersion(other.edgeVersion){}
     std::vector<Node> nodes;
     std::vector<Edge> edges;
+    std::size_t edgeVersion = 0;
     void drawGraph(SimpleGraph & graph);
 
   signals:
-    void graphUpdated(SimpleGraph graph);
+    void graphUpdated();
 };
 
 void DrawGraph(SimpleGraph& userGraph);
 void InitGraphVisualizer(SimpleGraph& userGraph);
 
-Q_DECLARE_METATYPE(SimpleGraph) //allows use of Simplegraph in signals/slots
+/** A snapshot of the node positions handed from the layout to the window.
+ * The bounding box is measured by the layout thread while copying, and the
+ * edges are shared between frames until the graph's edges change. */
+struct Frame {
+    std::vector<Node> nodes;
+    std::shared_ptr<const std::vector<Edge> > edges;
+    double minX, maxX, minY, maxY;
+};
 
 class MyWidget : public QWidget {
     Q_OBJECT
@@ -96,11 +127,41 @@ public:
 
 protected:
     void paintEvent(QPaintEvent *event);
+    void wheelEvent(QWheelEvent *event);
+    void mousePressEvent(QMouseEvent *event);
+    void mouseMoveEvent(QMouseEvent *event);
+    void mouseReleaseEvent(QMouseEvent *event);
+    void mouseDoubleClickEvent(QMouseEvent *event);
 
 private:
-    SimpleGraph userGraph;
-    QTime last_run;
+    void render();
+
+    TripleBuffer<Frame> frames;           // Layout thread publishes, paintEvent reads
+    std::atomic<bool> paintPending{false}; // A repaint is queued and has not run yet
+    std::size_t droppedFrames = 0;        // Layout thread only: frames never shown
+
+    // GUI thread only: the last rendered picture, and the buffers it was
+    // drawn from, reused between renders
+    QPixmap cache;
+    bool cacheValid = false;              // Cleared when the view changes
+    std::vector<QPointF> points;          // Window positions of all nodes
+    std::vector<QPointF> visible;         // Those inside the window
+    std::vector<QLineF> lines;            // Edges not entirely off one side
+    std::vector<int> tiles;               // Node counts of the density tiles
+
+    // GUI thread only: the view, zoomed about the fitted layout, then panned
+    double zoom = 1.0;
+    QPointF pan;
+    QPoint dragStart;
+    bool dragging = false;
+
+    // Layout thread only: the edges of the last frame and where they came from
+    std::shared_ptr<const std::vector<Edge> > sharedEdges;
+    const SimpleGraph* edgesSource = nullptr;
+    const Edge* edgesData = nullptr;
+    std::size_t edgesVersion = 0;
     friend void SimpleGraph::drawGraph(SimpleGraph & graph);
+    friend std::size_t DroppedFrames();
 
 };
 
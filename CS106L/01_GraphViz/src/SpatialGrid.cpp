@@ -0,0 +1,90 @@
+#include <algorithm>
+#include <cmath>
+
+#include "SpatialGrid.h"
+
+// Far-apart outliers would make a grid of radius-wide cells huge, so the
+// cells grow until there are at most this many per node
+const std::size_t kMaxCellsPerNode = 4;
+
+inline std::size_t SpatialGrid::column(double x) const {
+    return std::min(std::size_t((x - minX_) / cellSize_), columns_ - 1);
+}
+
+inline std::size_t SpatialGrid::row(double y) const {
+    return std::min(std::size_t((y - minY_) / cellSize_), rows_ - 1);
+}
+
+// Bin the nodes with a counting sort over the cells
+void SpatialGrid::build(const double *x, const double *y, std::size_t n, double radius) {
+    order_.resize(n);
+    cellOf_.resize(n);
+    columns_ = rows_ = 1;
+    cellSize_ = radius;
+    radius2_ = radius * radius;
+    if (n == 0) return;
+
+    double minX = x[0], maxX = x[0];
+    double minY = y[0], maxY = y[0];
+    for (std::size_t i = 0; i < n; ++i) {
+        minX = std::min(minX, x[i]);
+        maxX = std::max(maxX, x[i]);
+        minY = std::min(minY, y[i]);
+        maxY = std::max(maxY, y[i]);
+    }
+    minX_ = minX;
+    minY_ = minY;
+
+    double width = maxX - minX, height = maxY - minY;
+    double maxCells = double(kMaxCellsPerNode) * n;
+    if (!(cellSize_ > 0))
+        cellSize_ = std::max(std::max(width, height), 1.0);
+    while ((width / cellSize_ + 1) * (height / cellSize_ + 1) > maxCells)
+        cellSize_ *= 2;
+    columns_ = std::size_t(width / cellSize_) + 1;
+    rows_ = std::size_t(height / cellSize_) + 1;
+
+    // Room for the most cells there can be, so that rebuilding the grid
+    // as the layout spreads out never reallocates
+    cellStart_.reserve(kMaxCellsPerNode * n + 1);
+    next_.reserve(kMaxCellsPerNode * n);
+    cellStart_.assign(columns_ * rows_ + 1, 0);
+    for (std::size_t i = 0; i < n; ++i) {
+        cellOf_[i] = row(y[i]) * columns_ + column(x[i]);
+        ++cellStart_[cellOf_[i] + 1];
+    }
+    for (std::size_t c = 0; c < columns_ * rows_; ++c)
+        cellStart_[c + 1] += cellStart_[c];
+
+    next_.assign(cellStart_.begin(), cellStart_.end() - 1);
+    for (std::size_t i = 0; i < n; ++i)
+        order_[next_[cellOf_[i]]++] = i;
+}
+
+// Visit the 3x3 block of cells around node i
+void SpatialGrid::repulsion(const double *x, const double *y, std::size_t i,
+                            double kRepel, double &fx, double &fy) const {
+    if (order_.empty()) return;
+
+    const double xi = x[i], yi = y[i];
+    std::size_t c = cellOf_[i];
+    std::size_t col = c % columns_, r = c / columns_;
+    std::size_t colBegin = col > 0 ? col - 1 : 0, colEnd = std::min(col + 2, columns_);
+    std::size_t rowBegin = r > 0 ? r - 1 : 0, rowEnd = std::min(r + 2, rows_);
+
+    for (std::size_t rr = rowBegin; rr < rowEnd; ++rr) {
+        // The cells of one row of the block are contiguous in order_
+        std::size_t begin = cellStart_[rr * columns_ + colBegin];
+        std::size_t end = cellStart_[rr * columns_ + colEnd];
+        for (std::size_t k = begin; k < end; ++k) {
+            std::size_t j = order_[k];
+            double dx = xi - x[j];
+            double dy = yi - y[j];
+            double d2 = dx * dx + dy * dy;
+            if (j == i || d2 >= radius2_) continue;
+            double f = kRepel / d2;
+            fx += f * dx;
+            fy += f * dy;
+        }
+    }
+}
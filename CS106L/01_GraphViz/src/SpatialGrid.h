@@ -0,0 +1,46 @@
+#pragma once
+
+/*************************************************************************
+ * File: SpatialGrid.h
+ *
+ * A uniform grid over the nodes of a graph, used for repulsion with a
+ * cutoff radius. With cells as wide as the radius, every node within the
+ * radius of a node lies in its own cell or one of the eight around it, so
+ * on an evenly spread layout a node only looks at a constant number of
+ * others and an iteration costs O(n) instead of O(n^2).
+ */
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Type: SpatialGrid
+ * -----------------------------------------------------------------------
+ * build() bins the current node positions, given as arrays x[] and y[],
+ * into cells at least radius wide; the grid must be rebuilt whenever the
+ * nodes move. repulsion() then returns the repulsive force on one node from
+ * the nodes within the radius.
+ */
+class SpatialGrid {
+public:
+    void build(const double* x, const double* y, std::size_t n, double radius);
+
+    /* Adds to (fx, fy) the force that the nodes closer than the radius exert
+     * on node i, with the pairwise force kRepel / d along the line between
+     * the nodes.
+     */
+    void repulsion(const double* x, const double* y, std::size_t i,
+                   double kRepel, double& fx, double& fy) const;
+
+private:
+    double minX_, minY_;
+    double cellSize_, radius2_;
+    std::size_t columns_, rows_;
+    std::vector<std::size_t> cellStart_;   // Cell c holds order_[cellStart_[c], cellStart_[c + 1])
+    std::vector<std::size_t> order_;       // Node indices, grouped by cell
+    std::vector<std::size_t> cellOf_;      // Cell of every node
+    std::vector<std::size_t> next_;        // Next free slot of every cell while binning
+
+    std::size_t column(double x) const;
+    std::size_t row(double y) const;
+};
@@ -0,0 +1,279 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "Stress.h"
+#include "Adjacency.h"
+#include "ThreadPool.h"
+
+using std::uint32_t;
+using std::vector;
+
+// Pivots of the sparse model when StressOptions leaves it to the size
+const int kDefaultPivots = 200;
+
+// Distance of nodes a breadth-first search has not reached
+const uint32_t kUnreached = uint32_t(-1);
+
+// The hop distances from source to every node, using queue as scratch
+static void Bfs(const Adjacency &adjacency, uint32_t source, uint32_t *dist,
+                vector<uint32_t> &queue) {
+    std::fill(dist, dist + adjacency.numNodes(), kUnreached);
+    queue.clear();
+    queue.push_back(source);
+    dist[source] = 0;
+    for (size_t head = 0; head < queue.size(); ++head) {
+        uint32_t u = queue[head];
+        for (uint32_t k = adjacency.offsets[u]; k < adjacency.offsets[u + 1]; ++k) {
+            uint32_t v = adjacency.neighbors[k];
+            if (dist[v] != kUnreached) continue;
+            dist[v] = dist[u] + 1;
+            queue.push_back(v);
+        }
+    }
+}
+
+/* The terms of the stress model as CSR lists: the terms of node i pull it
+ * toward nodes[k] at distance dist[k] with weight weight[k], for k from
+ * offsets[i] to offsets[i + 1].
+ */
+struct StressTerms {
+    vector<size_t> offsets;
+    vector<uint32_t> nodes;
+    vector<float> dist;
+    vector<float> weight;
+
+    void add(uint32_t j, double d, double w) {
+        nodes.push_back(j);
+        dist.push_back(float(d));
+        weight.push_back(float(w));
+    }
+};
+
+// A term for every pair, from a breadth-first search per node on threads.
+// Every thread fills the rows of its own range of nodes.
+static void FullTerms(const Adjacency &adjacency, ThreadPool &pool, StressTerms &terms) {
+    size_t n = adjacency.numNodes();
+    vector<uint32_t> dist(n * n);
+    vector<uint32_t> maxDist(pool.size(), 0);
+    pool.run([&](size_t t) {
+        vector<uint32_t> queue;
+        for (size_t i = SplitRange(n, pool.size(), t); i < SplitRange(n, pool.size(), t + 1); ++i) {
+            uint32_t *row = &dist[i * n];
+            Bfs(adjacency, uint32_t(i), row, queue);
+            maxDist[t] = std::max(maxDist[t], row[queue.back()]);
+        }
+    });
+    double unreached = *std::max_element(maxDist.begin(), maxDist.end()) + 1.0;
+
+    terms.offsets.assign(1, 0);
+    terms.nodes.reserve(n * (n - 1));
+    terms.dist.reserve(n * (n - 1));
+    terms.weight.reserve(n * (n - 1));
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            if (j == i) continue;
+            double d = dist[i * n + j] == kUnreached ? unreached : dist[i * n + j];
+            terms.add(uint32_t(j), d, 1.0 / (d * d));
+        }
+        terms.offsets.push_back(terms.nodes.size());
+    }
+}
+
+// The sparse model: max-min pivots, each one the node farthest from those
+// chosen so far, then for every node its edges and a term per pivot.
+// Pivot p's term for node i is weighted by the number of nodes of p's
+// region, the nodes closer to p than to any other pivot, that lie within
+// half of d_ip of it.
+static void SparseTerms(const Adjacency &adjacency, size_t numPivots, StressTerms &terms) {
+    size_t n = adjacency.numNodes();
+    numPivots = std::min(numPivots, n);
+    vector<uint32_t> pivots, dist(numPivots * n), queue;
+    vector<uint32_t> nearest(n, 0), nearestDist(n, kUnreached);
+    uint32_t maxDist = 0, next = 0;
+    for (size_t p = 0; p < numPivots; ++p) {
+        pivots.push_back(next);
+        uint32_t *row = &dist[p * n];
+        Bfs(adjacency, next, row, queue);
+        maxDist = std::max(maxDist, row[queue.back()]);
+        for (size_t i = 0; i < n; ++i) {
+            if (row[i] < nearestDist[i]) {
+                nearestDist[i] = row[i];
+                nearest[i] = uint32_t(p);
+            }
+        }
+
+        // Unreached nodes count as farthest, so every component gets a pivot
+        next = 0;
+        for (size_t i = 1; i < n; ++i) {
+            if (nearestDist[i] > nearestDist[next]) next = uint32_t(i);
+        }
+    }
+    double unreached = maxDist + 1.0;
+
+    // The distances of every region's nodes from its pivot, sorted
+    vector<vector<uint32_t> > regions(numPivots);
+    for (size_t i = 0; i < n; ++i)
+        regions[nearest[i]].push_back(nearestDist[i]);
+    for (size_t p = 0; p < numPivots; ++p)
+        std::sort(regions[p].begin(), regions[p].end());
+
+    terms.offsets.assign(1, 0);
+    for (size_t i = 0; i < n; ++i) {
+        for (uint32_t k = adjacency.offsets[i]; k < adjacency.offsets[i + 1]; ++k)
+            terms.add(adjacency.neighbors[k], 1.0, 1.0);
+        for (size_t p = 0; p < numPivots; ++p) {
+            uint32_t hops = dist[p * n + i];
+            if (hops <= 1) continue;
+            double d = hops == kUnreached ? unreached : hops;
+            double share = std::upper_bound(regions[p].begin(), regions[p].end(), uint32_t(d / 2)) -
+                           regions[p].begin();
+            terms.add(pivots[p], d, std::max(share, 1.0) / (d * d));
+        }
+        terms.offsets.push_back(terms.nodes.size());
+    }
+}
+
+// Build the terms, then run localized updates from the scaled start positions.
+// Positions and the next positions live in separate x/y arrays, so that
+// every thread updates its own range of nodes from the same old layout.
+LayoutStats StressLayout(SimpleGraph &graph, const LayoutOptions &options,
+                         const StressOptions &stress) {
+    auto startTime = std::chrono::steady_clock::now();
+    LayoutStats stats;
+    size_t n = graph.nodes.size();
+    Adjacency adjacency;
+    BuildAdjacency(n, graph.edges, adjacency);
+    ThreadPool pool(options.threads);
+    size_t numThreads = pool.size();
+
+    StressTerms terms;
+    int numPivots = stress.pivots >= 0 ? stress.pivots : (n <= kFullStressMaxNodes ? 0 : kDefaultPivots);
+    if (numPivots == 0)
+        FullTerms(adjacency, pool, terms);
+    else
+        SparseTerms(adjacency, numPivots, terms);
+
+    // Edges of length 1 on average, the unit of the distances
+    double length = 0;
+    for (size_t e = 0; e < graph.edges.size(); ++e) {
+        const Node &a = graph.nodes[graph.edges[e].start], &b = graph.nodes[graph.edges[e].end];
+        length += std::hypot(a.x - b.x, a.y - b.y);
+    }
+    double scale = graph.edges.empty() || length == 0 ? 1.0 : graph.edges.size() / length;
+    vector<double> xs(n), ys(n), nextXs(n), nextYs(n);
+    for (size_t i = 0; i < n; ++i) {
+        xs[i] = scale * graph.nodes[i].x;
+        ys[i] = scale * graph.nodes[i].y;
+    }
+
+    vector<double> partStress(numThreads), partMove(numThreads);
+    while (true) {
+        // Every node goes to the weighted mean of the points at distance
+        // d_ij from each x_j, in the direction it lies in now
+        pool.run([&](size_t t) {
+            double sum = 0, maxMove2 = 0;
+            for (size_t i = SplitRange(n, numThreads, t); i < SplitRange(n, numThreads, t + 1); ++i) {
+                double x = 0, y = 0, weights = 0;
+                for (size_t k = terms.offsets[i]; k < terms.offsets[i + 1]; ++k) {
+                    uint32_t j = terms.nodes[k];
+                    double d = terms.dist[k], w = terms.weight[k];
+                    double dx = xs[i] - xs[j], dy = ys[i] - ys[j];
+                    double distance = std::sqrt(dx * dx + dy * dy);
+                    sum += w * (distance - d) * (distance - d);
+                    double pull = distance > 0 ? d / distance : 0.0;
+                    x += w * (xs[j] + pull * dx);
+                    y += w * (ys[j] + pull * dy);
+                    weights += w;
+                }
+                nextXs[i] = weights > 0 ? x / weights : xs[i];
+                nextYs[i] = weights > 0 ? y / weights : ys[i];
+                double mx = nextXs[i] - xs[i], my = nextYs[i] - ys[i];
+                maxMove2 = std::max(maxMove2, mx * mx + my * my);
+            }
+            partStress[t] = sum;
+            partMove[t] = maxMove2;
+        });
+        xs.swap(nextXs);
+        ys.swap(nextYs);
+
+        double minX = HUGE_VAL, maxX = -HUGE_VAL, minY = HUGE_VAL, maxY = -HUGE_VAL;
+        for (size_t i = 0; i < n; ++i) {
+            minX = std::min(minX, xs[i]);
+            maxX = std::max(maxX, xs[i]);
+            minY = std::min(minY, ys[i]);
+            maxY = std::max(maxY, ys[i]);
+        }
+        double size = n > 0 ? std::hypot(maxX - minX, maxY - minY) : 0.0;
+
+        ++stats.iterations;
+        stats.energy = 0;
+        double maxMove2 = 0;
+        for (size_t t = 0; t < numThreads; ++t) {
+            stats.energy += partStress[t];
+            maxMove2 = std::max(maxMove2, partMove[t]);
+        }
+        stats.maxDisplacement = std::sqrt(maxMove2) / (size > 0 ? size : 1.0);
+        stats.converged = options.tolerance > 0 && stats.maxDisplacement < options.tolerance;
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+        stats.seconds = elapsed.count();
+        bool done = stats.converged ||
+            (options.seconds > 0 && stats.seconds >= options.seconds) ||
+            (options.iterations > 0 && stats.iterations >= size_t(options.iterations));
+
+        if (options.draw || done) {
+            for (size_t i = 0; i < n; ++i) {
+                graph.nodes[i].x = xs[i];
+                graph.nodes[i].y = ys[i];
+            }
+        }
+        if (options.draw && options.onDraw)
+            options.onDraw(graph);
+        else if (options.draw)
+            DrawGraph(graph);
+        if (done) {
+            stats.graphIterations = stats.iterations;
+            return stats;
+        }
+    }
+}
+
+// Every thread sums the terms of its own sources, a row at a time, then
+// the best scale s minimizes sum w (s |x_i - x_j| - d)^2
+double NormalizedStress(const SimpleGraph &graph, size_t threads) {
+    size_t n = graph.nodes.size();
+    Adjacency adjacency;
+    BuildAdjacency(n, graph.edges, adjacency);
+    ThreadPool pool(threads);
+    size_t numThreads = pool.size();
+
+    // Sums of w |x|^2, w |x| d and w d^2 = 1 per thread
+    vector<double> xx(numThreads), xd(numThreads), dd(numThreads);
+    pool.run([&](size_t t) {
+        vector<uint32_t> dist(n), queue;
+        for (size_t i = SplitRange(n, numThreads, t); i < SplitRange(n, numThreads, t + 1); ++i) {
+            Bfs(adjacency, uint32_t(i), dist.data(), queue);
+            for (size_t k = 1; k < queue.size(); ++k) {
+                uint32_t j = queue[k];
+                double d = dist[j];
+                double x = std::hypot(graph.nodes[i].x - graph.nodes[j].x, graph.nodes[i].y - graph.nodes[j].y);
+                xx[t] += x * x / (d * d);
+                xd[t] += x / d;
+                dd[t] += 1;
+            }
+        }
+    });
+    double sumXX = 0, sumXD = 0, sumDD = 0;
+    for (size_t t = 0; t < numThreads; ++t) {
+        sumXX += xx[t];
+        sumXD += xd[t];
+        sumDD += dd[t];
+    }
+    if (sumXX == 0 || sumDD == 0)
+        return 0.0;
+
+    // sum w (s x - d)^2 at s = sumXD / sumXX
+    return (sumDD - sumXD * sumXD / sumXX) / sumDD;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+/*************************************************************************
+ * File: Stress.h
+ *
+ * A stress-majorization layout engine, an alternative to the force
+ * simulation in Layout.h. It looks for positions whose distances match the
+ * shortest-path distances d_ij of the graph, minimizing the stress
+ *
+ *     sum over pairs of w_ij (|x_i - x_j| - d_ij)^2,   w_ij = d_ij^-2,
+ *
+ * with localized majorization updates: every node moves to the weighted
+ * mean of where each of its terms would like it to be, given where the
+ * other nodes were in the previous iteration. All nodes move at once, in
+ * the manner of a Jacobi iteration, so unlike the Guttman transform of
+ * SMACOF an iteration is not guaranteed to lower the stress, though in
+ * practice it falls steadily. The result only depends on the start
+ * positions.
+ */
+
+#include <cstddef>
+
+#include "SimpleGraph.h"
+#include "Layout.h"
+
+/**
+ * Type: StressOptions
+ * -----------------------------------------------------------------------
+ * Settings of the stress model on top of the LayoutOptions.
+ *
+ * With pivots = 0 every pair of nodes is a term, which takes a
+ * breadth-first search from every node and memory quadratic in the number
+ * of nodes. With pivots > 0 the sparse stress model of Ortmann, Klimenta
+ * and Brandes is used instead: every node keeps terms for its edges and for
+ * that many pivot nodes, chosen far apart, each pivot standing in for the
+ * nodes closest to it. pivots = -1 uses full stress up to
+ * kFullStressMaxNodes nodes and 200 pivots above.
+ *
+ * Pairs in different components are kept one more than the largest
+ * distance apart.
+ */
+struct StressOptions {
+    int pivots = -1;
+};
+
+/**
+ * Constant: kFullStressMaxNodes
+ * -----------------------------------------------------------------------
+ * The largest graph that gets full stress by default, about 50 MB of
+ * terms.
+ */
+const std::size_t kFullStressMaxNodes = 2000;
+
+/**
+ * Function: StressLayout(SimpleGraph& graph, const LayoutOptions& options,
+ *                        const StressOptions& stress)
+ * -----------------------------------------------------------------------
+ * Lays out the graph by stress majorization, starting from its current
+ * positions scaled to a mean edge length of 1, until the first limit in
+ * options is reached. Of the force settings only the limits, threads and
+ * draw apply; tolerance is relative to the layout size, as for
+ * ForceDirected(). The stats report the stress of the model as the energy.
+ * The layout comes out in units of edge lengths.
+ */
+LayoutStats StressLayout(SimpleGraph& graph, const LayoutOptions& options,
+                         const StressOptions& stress = StressOptions());
+
+/**
+ * Function: NormalizedStress(const SimpleGraph& graph, std::size_t threads)
+ * -----------------------------------------------------------------------
+ * Measures the quality of any layout of the graph: its full stress after
+ * the best uniform scaling, divided by the sum of w_ij d_ij^2, so 0 is a
+ * perfect embedding of the graph distances. Pairs in different components
+ * are skipped. Takes a breadth-first search from every node, on threads
+ * (0 for one per core), but no quadratic memory.
+ */
+double NormalizedStress(const SimpleGraph& graph, std::size_t threads = 0);
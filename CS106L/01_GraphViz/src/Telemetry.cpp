@@ -0,0 +1,46 @@
+#include <fstream>
+#include <limits>
+
+#include "Telemetry.h"
+
+Telemetry::Telemetry(std::size_t capacity)
+    : records_(capacity > 0 ? capacity : 1), next_(0), count_(0) {}
+
+void Telemetry::setCallback(const std::function<void(const IterationRecord &)> &callback) {
+    callback_ = callback;
+}
+
+// Overwrite the oldest record once the buffer is full
+void Telemetry::record(const IterationRecord &record) {
+    records_[next_] = record;
+    next_ = (next_ + 1) % records_.size();
+    if (count_ < records_.size()) ++count_;
+    if (callback_) callback_(record);
+}
+
+std::size_t Telemetry::size() const {
+    return count_;
+}
+
+const IterationRecord &Telemetry::at(std::size_t k) const {
+    return records_[(next_ + records_.size() - count_ + k) % records_.size()];
+}
+
+void Telemetry::clear() {
+    next_ = count_ = 0;
+}
+
+bool Telemetry::dump(const std::string &path) const {
+    std::ofstream output(path.c_str());
+    output.precision(std::numeric_limits<double>::digits10);
+    output << "iteration,repulsion_s,attraction_s,integration_s,draw_s,energy,max_force,"
+           << "total_displacement,temperature,step,dropped_frames\n";
+    for (std::size_t k = 0; k < count_; ++k) {
+        const IterationRecord &r = at(k);
+        output << r.iteration << "," << r.repulsionSeconds << "," << r.attractionSeconds << ","
+               << r.integrationSeconds << "," << r.drawSeconds << "," << r.energy << ","
+               << r.maxForce << "," << r.totalDisplacement << "," << r.temperature << ","
+               << r.step << "," << r.droppedFrames << "\n";
+    }
+    return bool(output);
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+/*************************************************************************
+ * File: Telemetry.h
+ *
+ * Per-iteration measurements of the force-directed layout: how long each
+ * phase of an iteration took and how the layout moved. The measuring code
+ * in ForceDirected() only exists in builds with GRAPHVIZ_TELEMETRY defined
+ * (uncomment the DEFINES line in GraphViz.pro); in other builds the checks
+ * are constant false and the compiler drops them, so the layout loop pays
+ * nothing for them.
+ */
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#ifdef GRAPHVIZ_TELEMETRY
+const bool kTelemetryEnabled = true;
+#else
+const bool kTelemetryEnabled = false;
+#endif
+
+/**
+ * Type: IterationRecord
+ * -----------------------------------------------------------------------
+ * One iteration of ForceDirected(). The repulsion and attraction times are
+ * those of the slowest thread, which is what the iteration waits for.
+ */
+struct IterationRecord {
+    std::size_t iteration = 0;        // From 1, restarting with every run
+    double repulsionSeconds = 0.0;    // Tree or grid build and repulsive forces
+    double attractionSeconds = 0.0;   // Pull along the edges
+    double integrationSeconds = 0.0;  // Moving the nodes and the cooling schedule
+    double drawSeconds = 0.0;         // Copying positions back and DrawGraph()
+    double energy = 0.0;              // Sum of the squared forces
+    double maxForce = 0.0;            // Largest force on a node
+    double totalDisplacement = 0.0;   // Sum of the distances the nodes moved
+    double temperature = 0.0;         // Cap on a move after the iteration
+    double step = 0.0;                // Force multiplier after the iteration
+    std::size_t droppedFrames = 0;    // Frames the window skipped, see DroppedFrames()
+};
+
+/**
+ * Type: Telemetry
+ * -----------------------------------------------------------------------
+ * A ring buffer of the latest records, and an optional callback that sees
+ * every record as it comes in. Point LayoutOptions::telemetry at one to
+ * collect records; it is not thread-safe, so read it from the callback or
+ * after the layout returns.
+ */
+class Telemetry {
+public:
+    explicit Telemetry(std::size_t capacity = 4096);
+
+    /* Calls callback with every record from now on. */
+    void setCallback(const std::function<void(const IterationRecord&)>& callback);
+    void record(const IterationRecord& record);
+
+    /* The records held, at most capacity; at(0) is the oldest. */
+    std::size_t size() const;
+    const IterationRecord& at(std::size_t k) const;
+    void clear();
+
+    /* Writes the records as CSV with a header line, returning false if the
+     * file cannot be written. */
+    bool dump(const std::string& path) const;
+
+private:
+    std::vector<IterationRecord> records_;
+    std::size_t next_;    // Slot of the next record
+    std::size_t count_;
+    std::function<void(const IterationRecord&)> callback_;
+};
@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <vector>
+
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(std::size_t numThreads)
+    : task_(NULL), generation_(0), pending_(0), stopping_(false) {
+    if (numThreads == 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t i = 1; i < numThreads; ++i)
+        workers_.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (std::size_t i = 0; i < workers_.size(); ++i)
+        workers_[i].join();
+}
+
+std::size_t ThreadPool::size() const {
+    return workers_.size() + 1;
+}
+
+// Publish the task to the workers, run part 0 here, then wait for the rest
+void ThreadPool::run(const std::function<void(std::size_t)> &task) {
+    if (!workers_.empty()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        task_ = &task;
+        pending_ = workers_.size();
+        ++generation_;
+    }
+    wake_.notify_all();
+
+    task(0);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (pending_ > 0)
+        done_.wait(lock);
+    task_ = NULL;
+}
+
+// Every thread works through its own slice from the front; a thread whose
+// slice is empty moves the back half of the fullest other slice into its
+// own. Slices only shrink from the front under their owner and from the
+// back under a thief, so every task runs exactly once.
+void ThreadPool::runTasks(std::size_t count, const std::function<void(std::size_t, std::size_t)> &task) {
+    struct Slice {
+        std::mutex mutex;
+        std::size_t begin, end;
+    };
+    std::size_t numThreads = size();
+    std::vector<Slice> slices(numThreads);
+    for (std::size_t t = 0; t < numThreads; ++t) {
+        slices[t].begin = SplitRange(count, numThreads, t);
+        slices[t].end = SplitRange(count, numThreads, t + 1);
+    }
+
+    run([&](std::size_t t) {
+        Slice &own = slices[t];
+        while (true) {
+            std::size_t k = 0;
+            bool found = false;
+            {
+                std::lock_guard<std::mutex> lock(own.mutex);
+                if (own.begin < own.end) {
+                    k = own.begin++;
+                    found = true;
+                }
+            }
+            if (found) {
+                task(k, t);
+                continue;
+            }
+
+            std::size_t victim = numThreads, most = 0;
+            for (std::size_t v = 0; v < numThreads; ++v) {
+                if (v == t) continue;
+                std::lock_guard<std::mutex> lock(slices[v].mutex);
+                if (slices[v].end - slices[v].begin > most) {
+                    most = slices[v].end - slices[v].begin;
+                    victim = v;
+                }
+            }
+            if (victim == numThreads) return;
+
+            std::size_t begin, end;
+            {
+                std::lock_guard<std::mutex> lock(slices[victim].mutex);
+                end = slices[victim].end;
+                begin = end - (end - slices[victim].begin + 1) / 2;
+                slices[victim].end = begin;
+            }
+            std::lock_guard<std::mutex> lock(own.mutex);
+            own.begin = begin;
+            own.end = end;
+        }
+    });
+}
+
+void ThreadPool::workerLoop(std::size_t index) {
+    std::size_t seen = 0;
+    while (true) {
+        const std::function<void(std::size_t)>* task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (generation_ == seen && !stopping_)
+                wake_.wait(lock);
+            if (stopping_) return;
+            seen = generation_;
+            task = task_;
+        }
+
+        (*task)(index);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--pending_ == 0)
+            done_.notify_one();
+    }
+}
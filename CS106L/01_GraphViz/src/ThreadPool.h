@@ -0,0 +1,65 @@
+#pragma once
+
+/*************************************************************************
+ * File: ThreadPool.h
+ *
+ * A fixed set of worker threads for the data-parallel phases of the layout.
+ * Threads are started once and reused, so handing a phase to the pool costs
+ * a wake-up rather than a thread start.
+ */
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Type: ThreadPool
+ * -----------------------------------------------------------------------
+ * run(task) calls task(0), task(1), ..., task(size() - 1) in parallel and
+ * returns once all of them are done. The calling thread runs task(0), so a
+ * pool of size 1 starts no threads at all.
+ *
+ * runTasks(count, task) calls task(k, thread) once for every k in
+ * [0, count), where thread is the index of the thread running it, for
+ * per-thread scratch. Every thread starts on an equal slice of the tasks
+ * and, once its slice runs dry, steals the back half of the fullest slice
+ * left, so tasks of very different lengths still keep every thread busy.
+ */
+class ThreadPool {
+public:
+    /* Creates a pool of numThreads threads, or one per core if 0. */
+    explicit ThreadPool(std::size_t numThreads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    std::size_t size() const;
+    void run(const std::function<void(std::size_t)>& task);
+    void runTasks(std::size_t count, const std::function<void(std::size_t, std::size_t)>& task);
+
+private:
+    void workerLoop(std::size_t index);
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    const std::function<void(std::size_t)>* task_;
+    std::size_t generation_;   // Bumped for every run()
+    std::size_t pending_;      // Workers still busy with the current run()
+    bool stopping_;
+};
+
+/**
+ * Function: SplitRange(count, parts, part)
+ * -----------------------------------------------------------------------
+ * Returns the first index of the part-th of parts equal slices of
+ * [0, count); part == parts gives count.
+ */
+inline std::size_t SplitRange(std::size_t count, std::size_t parts, std::size_t part) {
+    return count * part / parts;
+}
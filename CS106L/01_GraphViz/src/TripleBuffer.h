@@ -0,0 +1,73 @@
+#pragma once
+
+/*************************************************************************
+ * File: TripleBuffer.h
+ *
+ * A lock-free triple buffer for handing frames from one producer thread to
+ * one consumer thread. The producer always has a slot of its own to fill
+ * and never waits; the consumer always reads the latest finished frame and
+ * never waits either. Frames the consumer was too slow to see are simply
+ * overwritten.
+ */
+
+#include <atomic>
+
+/**
+ * Type: TripleBuffer<T>
+ * -----------------------------------------------------------------------
+ * Three slots: the back slot belongs to the producer, the front slot to the
+ * consumer, and the middle slot holds the latest published frame. publish()
+ * swaps back and middle and update() swaps middle and front, each with a
+ * single atomic exchange. The slots are reused rather than reallocated, so
+ * a producer that assigns into back() keeps the capacity of old frames.
+ *
+ * back() and publish() may only be called by the producer, update() and
+ * front() only by the consumer.
+ */
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() : state_(kMiddle), back_(kBack), front_(kFront) {}
+
+    TripleBuffer(const TripleBuffer& rhs) = delete;
+    TripleBuffer& operator=(const TripleBuffer& rhs) = delete;
+
+    /* The slot the producer fills before calling publish(). */
+    T& back() {
+        return slots_[back_];
+    }
+
+    /* Makes the back slot the latest frame and hands the producer a free
+     * slot in return. Returns true if that replaced a frame the consumer
+     * never read. */
+    bool publish() {
+        unsigned old = state_.exchange(back_ | kFresh, std::memory_order_acq_rel);
+        back_ = old & kIndex;
+        return (old & kFresh) != 0;
+    }
+
+    /* Moves the latest frame to the front if there is a new one since the
+     * last call, returning whether there was. */
+    bool update() {
+        if (!(state_.load(std::memory_order_relaxed) & kFresh))
+            return false;
+        front_ = state_.exchange(front_, std::memory_order_acq_rel) & kIndex;
+        return true;
+    }
+
+    /* The frame the consumer reads, valid until the next update(). */
+    const T& front() const {
+        return slots_[front_];
+    }
+
+private:
+    // The middle slot's index, with kFresh set when it has not been read yet
+    static const unsigned kIndex = 3;
+    static const unsigned kFresh = 4;
+    static const unsigned kBack = 0, kMiddle = 1, kFront = 2;
+
+    T slots_[3];
+    std::atomic<unsigned> state_;
+    unsigned back_;    // Producer only
+    unsigned front_;   // Consumer only
+};
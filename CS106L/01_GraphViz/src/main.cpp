@@ -1,29 +1,62 @@
-#include <cmath>
-#include <ctime>
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 #include <fstream>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "SimpleGraph.h"
+#include "Batch.h"
+#include "Benchmark.h"
+#include "Checkpoint.h"
+#include "Components.h"
+#include "GraphIO.h"
+#include "Layout.h"
+#include "Multilevel.h"
+#include "Placement.h"
+#include "Stress.h"
+#include "Telemetry.h"
 
 using std::cout;	using std::endl;
 using std::cin;
 using std::vector;
 
-// Constant number
-const double kPi = 3.14159265358979323;
-const double kRepel = 1e-3;
-const double kAttract = 1e-3;
+// Graphs with at least this many nodes are laid out with Barnes-Hut and the
+// multilevel scheme
+const size_t kBarnesHutMinNodes = 1000;
+const double kBarnesHutTheta = 0.8;
+const size_t kMultilevelMinNodes = 1000;
 
 void Welcome();
 void InitGraph(SimpleGraph &graph);
-void OpenUserFile(std::ifstream &input);
-void LoadGraph(SimpleGraph &graph ,std::ifstream &input);
-void ForceDirected(SimpleGraph &graph, int seconds);
+void OpenUserFile(SimpleGraph &graph);
+LayoutStats RunLayout(SimpleGraph &graph, const LayoutOptions &options, int multilevel,
+                      bool split, ComponentOptions components);
+int RunHeadless(int argc, char **argv);
+int RunConvert(int argc, char **argv);
 
 // Main method
-int main() {
+int main(int argc, char **argv) {
+    if (argc > 1 && std::string(argv[1]) == "--benchmark")
+        return RunCutoffBenchmark(argc, argv);
+    if (argc > 1 && std::string(argv[1]) == "--benchmark-placement")
+        return RunPlacementBenchmark(argc, argv);
+    if (argc > 1 && std::string(argv[1]) == "--benchmark-stress")
+        return RunStressBenchmark(argc, argv);
+    if (argc > 1 && std::string(argv[1]) == "--benchmark-suite")
+        return RunSuiteBenchmark(argc, argv);
+    if (argc > 1 && std::string(argv[1]) == "--batch")
+        return RunBatch(argc, argv);
+    if (argc > 1 && std::string(argv[1]) == "--check-allocations")
+        return RunAllocationCheck(argc, argv);
+    if (argc > 1 && std::string(argv[1]) == "--check-incremental")
+        return RunIncrementalCheck(argc, argv);
+    if (argc > 1 && std::string(argv[1]) == "--convert")
+        return RunConvert(argc, argv);
+    if (argc > 1)
+        return RunHeadless(argc, argv);
+
     Welcome();
     SimpleGraph graph;
     InitGraph(graph);
@@ -36,7 +69,12 @@ int main() {
 
         cout << "Sorry, you should enter a positive number" << endl;
     }
-    ForceDirected(graph, seconds);
+
+    LayoutOptions options;
+    options.seconds = seconds;
+    if (graph.nodes.size() >= kBarnesHutMinNodes)
+        options.theta = kBarnesHutTheta;
+    RunLayout(graph, options, -1, true, ComponentOptions());
 
 
     return 0;
@@ -51,96 +89,203 @@ void Welcome() {
     cout << endl;
 }
 
-// Open user file
-void OpenUserFile(std::ifstream &input) {
+// Open user file and load the graph in it
+void OpenUserFile(SimpleGraph &graph) {
     while(true) {
         cout << "Please enter filename to read: ";
         std::string file_name;
         std::getline(std::cin, file_name);
 
-        input.open(file_name.c_str());
-        if(input.is_open()) return;
+        if(LoadGraph(graph, file_name)) return;
 
-        cout << "Sorry, I can't find the file " << file_name << endl;
-        input.clear();
+        cout << "Sorry, I can't read the graph in " << file_name << endl;
     }
 }
 
 // Initialize the graph
 void InitGraph(SimpleGraph &graph) {
     InitGraphVisualizer(graph);
-    std::ifstream input;
-    OpenUserFile(input);
-    LoadGraph(graph, input);
+    OpenUserFile(graph);
     DrawGraph(graph);
 }
 
-// Load graph, including nodes and edges
-void LoadGraph(SimpleGraph &graph, std::ifstream &input) {
-    int nodes_num;
-    input >> nodes_num;
+// Lay out the graph one connected component at a time if split is set, or
+// all at once otherwise, starting from the placement in components. Graphs
+// or components use the multilevel scheme if multilevel is 1, or if it is -1
+// and they are large, unless components asks for stress majorization.
+LayoutStats RunLayout(SimpleGraph &graph, const LayoutOptions &options, int multilevel,
+                      bool split, ComponentOptions components) {
+    if (multilevel == 1) components.multilevelMinNodes = 0;
+    else if (multilevel == -1) components.multilevelMinNodes = kMultilevelMinNodes;
+    if (split)
+        return ComponentLayout(graph, options, components);
 
-    for (int i = 0; i < nodes_num; ++i) {
-        double x = std::cos(2 * kPi * i / nodes_num);
-        double y = std::sin(2 * kPi * i / nodes_num);
+    components.placement(graph, components.seed);
+    if (components.stress)
+        return StressLayout(graph, options);
+    if (graph.nodes.size() >= components.multilevelMinNodes)
+        return MultilevelLayout(graph, options);
+    return ForceDirected(graph, options);
+}
 
-        struct Node node = {x, y};
-        graph.nodes.push_back(node);
-    }
+/* Prints how to run the program without a window. */
+void PrintUsage(const char *program) {
+    cout << "Usage: " << program << " --headless <graph-file> <layout-file>" << endl;
+    cout << "           [--iterations N] [--tolerance T] [--seconds S]" << endl;
+    cout << "           [--temperature T0] [--cooling C]" << endl;
+    cout << "           [--theta THETA] [--cutoff C] [--threads K]" << endl;
+    cout << "           [--multilevel 0|1] [--reorder 0|1]" << endl;
+    cout << "           [--placement circle|random|bfs|spectral] [--seed S]" << endl;
+    cout << "           [--components 0|1] [--engine force|stress]" << endl;
+    cout << "           [--telemetry CSV-FILE]" << endl;
+    cout << "           [--checkpoint FILE] [--checkpoint-every N] [--resume FILE]" << endl;
+    cout << "Lays out the graph without drawing it and writes the final" << endl;
+    cout << "coordinates to the layout file. The layout stops once it has" << endl;
+    cout << "converged or at the first limit reached. Every connected" << endl;
+    cout << "component is laid out on its own and the results are packed" << endl;
+    cout << "together, unless --components 0 is given. Large components use" << endl;
+    cout << "the multilevel scheme unless --multilevel 0 is given; the" << endl;
+    cout << "initial placement only applies without it. --engine stress" << endl;
+    cout << "uses stress majorization instead of the force simulation." << endl;
+    cout << "--telemetry writes the phase times of the last iterations of" << endl;
+    cout << "the force layout, in builds with GRAPHVIZ_TELEMETRY." << endl;
+    cout << "--checkpoint saves the layout every N iterations (100 by" << endl;
+    cout << "default) in the background, and --resume continues from such" << endl;
+    cout << "a file if there is one; both run plain ForceDirected on the" << endl;
+    cout << "whole graph, without the multilevel scheme or components." << endl;
+}
 
-    size_t start, end;
-    while(input >> start >> end) {
-        struct Edge edge = {start, end};
-        graph.edges.push_back(edge);
+// Run the layout from the command line, without a window
+int RunHeadless(int argc, char **argv) {
+    if (argc < 4 || argc % 2 != 0 || std::string(argv[1]) != "--headless") {
+        PrintUsage(argv[0]);
+        return 1;
     }
-}
-// Implement the Force Directed algorithm
-void ForceDirected(SimpleGraph &graph, int seconds) {
-    time_t startTime = time(NULL);
-    while(true) {
-        size_t size = graph.nodes.size();
-        vector<double> deltXs(size, 0);
-        vector<double> deltYs(size, 0);
-        for (size_t i = 0; i < size - 1; ++i) {
-            for (size_t j = i + 1; j < size ; ++j) {
-                double x0 = graph.nodes[i].x;
-                double y0 = graph.nodes[i].y;
-                double x1 = graph.nodes[j].x;
-                double y1 = graph.nodes[j].y;
-                double Frepel = kRepel / sqrt(pow(y1 - y0, 2) + pow(x1 - x0, 2));
-                double theta = atan2(y1 - y0, x1 - x0);
-                deltXs[i] -= Frepel * cos(theta);
-                deltYs[i] -= Frepel * sin(theta);
-                deltXs[j] += Frepel * cos(theta);
-                deltYs[j] += Frepel * sin(theta);
-            }
-        }
 
-        size = graph.edges.size();
-        for (size_t i = 0; i < size; ++i) {
-            size_t start = graph.edges[i].start;
-            size_t end = graph.edges[i].end;
-            double x0 = graph.nodes[start].x;
-            double y0 = graph.nodes[start].y;
-            double x1 = graph.nodes[end].x;
-            double y1 = graph.nodes[end].y;
-            double Fattract = kAttract * (pow(y1 - y0, 2) + pow(x1 - x0, 2));
-            double theta = atan2(y1 - y0, x1 - x0);
-            deltXs[start] += Fattract * cos(theta);
-            deltYs[start] += Fattract * sin(theta);
-            deltXs[end] -= Fattract * cos(theta);
-            deltYs[end] -= Fattract * sin(theta);
+    LayoutOptions options;
+    options.seconds = 0;
+    options.draw = false;
+    int multilevel = -1;
+    bool split = true;
+    ComponentOptions components;
+    std::string telemetryFile, checkpointFile, resumeFile;
+    int checkpointEvery = 100;
+    for (int i = 4; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        if (flag == "--iterations") options.iterations = std::atoi(argv[i + 1]);
+        else if (flag == "--tolerance") options.tolerance = std::atof(argv[i + 1]);
+        else if (flag == "--seconds") options.seconds = std::atof(argv[i + 1]);
+        else if (flag == "--temperature") options.temperature = std::atof(argv[i + 1]);
+        else if (flag == "--cooling") options.cooling = std::atof(argv[i + 1]);
+        else if (flag == "--theta") options.theta = std::atof(argv[i + 1]);
+        else if (flag == "--cutoff") options.cutoff = std::atof(argv[i + 1]);
+        else if (flag == "--threads") options.threads = std::atoi(argv[i + 1]);
+        else if (flag == "--multilevel") multilevel = std::atoi(argv[i + 1]);
+        else if (flag == "--reorder") options.reorder = std::atoi(argv[i + 1]) != 0;
+        else if (flag == "--placement") components.placement = FindPlacement(argv[i + 1]);
+        else if (flag == "--seed") components.seed = std::strtoul(argv[i + 1], NULL, 10);
+        else if (flag == "--components") split = std::atoi(argv[i + 1]) != 0;
+        else if (flag == "--engine" && std::string(argv[i + 1]) == "force") components.stress = false;
+        else if (flag == "--engine" && std::string(argv[i + 1]) == "stress") components.stress = true;
+        else if (flag == "--telemetry") telemetryFile = argv[i + 1];
+        else if (flag == "--checkpoint") checkpointFile = argv[i + 1];
+        else if (flag == "--checkpoint-every") checkpointEvery = std::atoi(argv[i + 1]);
+        else if (flag == "--resume") resumeFile = argv[i + 1];
+        else {
+            PrintUsage(argv[0]);
+            return 1;
         }
+    }
+    if (components.placement == NULL || checkpointEvery <= 0 ||
+        (options.iterations <= 0 && options.tolerance <= 0 && options.seconds <= 0)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    SimpleGraph graph;
+    if (!LoadGraph(graph, argv[2])) {
+        std::cerr << "Sorry, I can't read the graph in " << argv[2] << endl;
+        return 1;
+    }
+
+    if (!telemetryFile.empty() && !kTelemetryEnabled) {
+        std::cerr << "Sorry, this build has no telemetry; define GRAPHVIZ_TELEMETRY" << endl;
+        return 1;
+    }
+    Telemetry telemetry;
+    if (!telemetryFile.empty())
+        options.telemetry = &telemetry;
 
-        size = graph.nodes.size();
-        for (size_t i = 0; i < size; ++i) {
-            graph.nodes[i].x += deltXs[i];
-            graph.nodes[i].y += deltYs[i];
+    // A checkpoint is the state of one ForceDirected run, so checkpointed
+    // runs lay out the whole graph at one level. A missing or stale
+    // checkpoint starts the run afresh, so the same command line can be
+    // rerun after every interruption.
+    SolverState resumed;
+    std::unique_ptr<CheckpointWriter> writer;
+    if (!checkpointFile.empty() || !resumeFile.empty()) {
+        if (split || multilevel != 0)
+            std::cerr << "Warning: checkpointed runs lay out the whole graph at one level, "
+                      << "without the multilevel scheme or components; large graphs will "
+                      << "take much longer to converge" << endl;
+        split = false;
+        multilevel = 0;
+    }
+    if (!resumeFile.empty()) {
+        if (LoadCheckpoint(resumeFile, graph, resumed)) {
+            options.resume = &resumed;
+            cout << "Resuming from " << resumeFile << " at iteration " << resumed.iterations << endl;
         }
+        else {
+            cout << "No checkpoint of this graph in " << resumeFile << ", starting afresh" << endl;
+        }
+    }
+    if (!checkpointFile.empty()) {
+        writer.reset(new CheckpointWriter(checkpointFile, checkpointEvery));
+        options.checkpoint = writer.get();
+    }
+
+    LayoutStats stats = options.resume ? ForceDirected(graph, options)
+                                       : RunLayout(graph, options, multilevel, split, components);
+    if (writer && writer->failed())
+        std::cerr << "Warning: some checkpoints could not be written to " << checkpointFile << endl;
+    writer.reset();
+    if (!telemetryFile.empty() && !telemetry.dump(telemetryFile)) {
+        std::cerr << "Sorry, I can't write the file " << telemetryFile << endl;
+        return 1;
+    }
 
-        DrawGraph(graph);
-        double elapsedTime = difftime(time(NULL), startTime);
-        if (elapsedTime >= seconds)
-            return ;
+    std::ofstream output(argv[3]);
+    WriteLayout(graph, output);
+    if (!output) {
+        std::cerr << "Sorry, I can't write the file " << argv[3] << endl;
+        return 1;
     }
+
+    cout << graph.nodes.size() << " nodes, " << graph.edges.size() << " edges: "
+         << stats.iterations << " iterations in " << stats.seconds << " s ("
+         << stats.iterations / std::max(stats.seconds, 1e-9) << " iterations/s), "
+         << (stats.converged ? "converged" : "not converged") << ", last max displacement "
+         << stats.maxDisplacement << ", energy " << stats.energy << endl;
+    return 0;
+}
+
+// Convert a graph file to the binary format
+int RunConvert(int argc, char **argv) {
+    if (argc != 4) {
+        cout << "Usage: " << argv[0] << " --convert <graph-file> <binary-file>" << endl;
+        cout << "Writes the graph in the binary format, which loads without parsing." << endl;
+        return 1;
+    }
+
+    SimpleGraph graph;
+    if (!LoadGraph(graph, argv[2])) {
+        std::cerr << "Sorry, I can't read the graph in " << argv[2] << endl;
+        return 1;
+    }
+    if (!WriteBinaryGraph(graph, argv[3])) {
+        std::cerr << "Sorry, I can't write the file " << argv[3] << endl;
+        return 1;
+    }
+    cout << graph.nodes.size() << " nodes, " << graph.edges.size() << " edges written" << endl;
+    return 0;
 }
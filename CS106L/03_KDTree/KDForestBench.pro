@@ -0,0 +1,20 @@
+TEMPLATE = app
+TARGET = kd-forest-bench
+
+# A console tool without Qt, built from the headers in src/
+CONFIG += console
+CONFIG -= app_bundle qt
+
+INCLUDEPATH += $$PWD/src
+
+SOURCES += $$PWD/tools/kd-forest-bench.cpp
+
+HEADERS += $$PWD/src/*.h
+
+# set up flags for the compiler
+QMAKE_CXXFLAGS += -std=c++11 \
+    -Wall \
+    -Wextra \
+    -Wreturn-type \
+    -Werror=return-type \
+    -Wunreachable-code \
@@ -0,0 +1,20 @@
+TEMPLATE = app
+TARGET = knn-classify
+
+# A console tool without Qt, built from the headers in src/
+CONFIG += console thread
+CONFIG -= app_bundle qt
+
+INCLUDEPATH += $$PWD/src
+
+SOURCES += $$PWD/tools/knn-classify.cpp
+
+HEADERS += $$PWD/src/*.h
+
+# set up flags for the compiler
+QMAKE_CXXFLAGS += -std=c++11 \
+    -Wall \
+    -Wextra \
+    -Wreturn-type \
+    -Werror=return-type \
+    -Wunreachable-code \
@@ -0,0 +1,592 @@
+/**
+ * File: CompressedKDTree.h
+ * Author: Zach Gu
+ * ------------------------
+ * A compact on-disk snapshot of a KDTree, and a reader that answers queries
+ * on it while loading only the parts of the file it needs.
+ *
+ * Every node is written in preorder as two child flags, its splitting
+ * dimension and its coordinates. A coordinate is not stored as a double but
+ * quantized to a few bits relative to the node's cell, the box carved out by
+ * the splits of its ancestors. Cells shrink with depth, so the absolute
+ * precision grows the deeper a node is. The snapshot is therefore lossy:
+ * each coordinate is off by at most about one quantum of its cell (plus one
+ * of the parent's), and queries are answered on the decoded points.
+ *
+ * The tree is cut at a fixed depth. The nodes above the cut form the top,
+ * which is decoded when the snapshot is opened; every subtree below the cut
+ * is a separately encoded block that is read from the file and decoded the
+ * first time a query reaches it.
+ *
+ * File layout (all numbers in the byte order of the machine that wrote it):
+ *   "KDTS", uint32 N, uint32 bits, uint32 sizeof(ElemType), uint64 count,
+ *   uint32 cut depth, N doubles of lower bounds, N doubles of upper bounds,
+ *   uint64 number of blocks B, B + 1 uint64 block offsets, uint64 top size,
+ *   the top bytes, then the blocks.
+ */
+
+#ifndef COMPRESSED_KDTREE_INCLUDED
+#define COMPRESSED_KDTREE_INCLUDED
+
+#include "KDTree.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <type_traits>
+
+template <size_t N, typename ElemType>
+class CompressedKDTree {
+public:
+    // static void save(const KDTree<N, ElemType>& tree, const string& path,
+    //                  size_t bits = 16, size_t blockNodes = 4096);
+    // Usage: CompressedKDTree<3, int>::save(kd, "index.kdts");
+    // ----------------------------------------------------
+    // Writes a snapshot of the tree to the file, quantizing every coordinate
+    // to the given number of bits (1 to 32). The blocks hold about blockNodes
+    // nodes each when the tree is balanced. Throws runtime_error if the file
+    // cannot be written.
+    static void save(const KDTree<N, ElemType>& tree, const string& path,
+                     size_t bits = 16, size_t blockNodes = 4096);
+
+    // Constructor: CompressedKDTree(const string& path);
+    // Usage: CompressedKDTree<3, int> snapshot("index.kdts");
+    // ----------------------------------------------------
+    // Opens a snapshot and decodes its top. Blocks are loaded on demand.
+    // Throws runtime_error if the file is missing or does not match N and
+    // ElemType.
+    explicit CompressedKDTree(const string& path);
+
+    // size_t dimension() const;
+    // size_t size() const;
+    // bool empty() const;
+    // Usage: if (snapshot.empty())
+    // ----------------------------------------------------
+    // Returns the dimension of the points, the number of points and whether
+    // the snapshot is empty, respectively.
+    size_t dimension() const;
+    size_t size() const;
+    bool empty() const;
+
+    // size_t blocksLoaded() const;
+    // Usage: cout << snapshot.blocksLoaded() << endl;
+    // ----------------------------------------------------
+    // Returns how many blocks are currently decoded in memory.
+    size_t blocksLoaded() const;
+
+    // void setMaxCachedBlocks(size_t maxBlocks);
+    // Usage: snapshot.setMaxCachedBlocks(64);
+    // ----------------------------------------------------
+    // Bounds the memory used by decoded blocks. When more blocks than this
+    // are cached, the cache is dropped before the next query. By default
+    // blocks are never dropped.
+    void setMaxCachedBlocks(size_t maxBlocks);
+
+    // ElemType kNNValue(const Point<N>& key, size_t k) const;
+    // Usage: cout << snapshot.kNNValue(v, 3) << endl;
+    // ----------------------------------------------------
+    // Same as KDTree::kNNValue, on the decoded points. Only the blocks whose
+    // cells may hold one of the k nearest points are loaded. Queries update
+    // the block cache, so they must not run concurrently.
+    ElemType kNNValue(const Point<N>& key, size_t k) const;
+
+    // KDTree<N, ElemType> decompress() const;
+    // Usage: KDTree<3, int> kd = snapshot.decompress();
+    // ----------------------------------------------------
+    // Decodes every block and bulk-builds a KDTree from the decoded points.
+    // Points that quantized to the same coordinates end up as one point.
+    KDTree<N, ElemType> decompress() const;
+
+private:
+    static_assert(std::is_trivially_copyable<ElemType>::value,
+                  "Snapshot values are stored as raw bytes");
+
+    // A decoded node. Children are indices into the same vector, -1 for
+    // none; in the top a child code c <= -2 is the root of block -c - 2.
+    struct DecodedNode {
+        Point<N> pt_;
+        ElemType value_;
+        size_t axis_;
+        long left_;
+        long right_;
+    };
+
+    // The box of points a node can hold
+    struct Cell {
+        Point<N> lo, hi;
+    };
+
+    class BitWriter;
+    class BitReader;
+
+    string path_;
+    size_t bits_;
+    size_t count_;
+    size_t cutDepth_;
+    Cell bounds_;
+    vector<uint64_t> blockOffsets_;
+    uint64_t payloadStart_;
+    vector<DecodedNode> top_;
+    vector<Cell> blockCells_;
+    size_t maxCachedBlocks_;
+    mutable map<size_t, vector<DecodedNode> > blocks_;
+
+    static size_t axisBits();
+    static uint32_t quantize(double x, double lo, double hi, size_t bits);
+    static double dequantize(uint32_t q, double lo, double hi, size_t bits);
+
+    // Helper functions writing a node and its subtree
+    typedef typename KDTree<N, ElemType>::Node TreeNode;
+    static void encodeNode(BitWriter& out, const TreeNode* node, const Cell& cell, size_t bits,
+                           Point<N>& decoded);
+    static void encodeTopRe(BitWriter& out, const TreeNode* node, Cell cell, size_t depth, size_t cutDepth,
+                            size_t bits, vector< pair<const TreeNode*, Cell> >& blockRoots);
+    static void encodeBlockRe(BitWriter& out, const TreeNode* node, Cell cell, size_t bits);
+
+    // Helper functions reading them back
+    void decodeNode(BitReader& in, const Cell& cell, DecodedNode& node, bool& hasLeft, bool& hasRight) const;
+    long decodeTopRe(BitReader& in, const Cell& cell, size_t depth);
+    long decodeBlockRe(BitReader& in, const Cell& cell, vector<DecodedNode>& nodes) const;
+    const vector<DecodedNode>& block(size_t index) const;
+
+    void kNNValueRe(const Point<N>& pt, BoundedPQueue<const DecodedNode*>& bpq,
+                    const vector<DecodedNode>& nodes, long index) const;
+};
+
+/** CompressedKDTree class implementation details */
+
+// BitWriter packs fields of up to 32 bits, least significant bit first
+template <size_t N, typename ElemType>
+class CompressedKDTree<N, ElemType>::BitWriter {
+public:
+    BitWriter() : acc_(0), used_(0) {}
+
+    void write(uint32_t value, size_t bits) {
+        acc_ |= static_cast<uint64_t>(value) << used_;
+        used_ += bits;
+        while (used_ >= 8) {
+            bytes_.push_back(static_cast<char>(acc_ & 0xff));
+            acc_ >>= 8;
+            used_ -= 8;
+        }
+    }
+
+    void writeBytes(const void* data, size_t size) {
+        const unsigned char *bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i)
+            write(bytes[i], 8);
+    }
+
+    // Pads the last byte and returns the stream
+    const string& finish() {
+        if (used_ > 0)
+            write(0, 8 - used_);
+        return bytes_;
+    }
+
+private:
+    string bytes_;
+    uint64_t acc_;
+    size_t used_;
+};
+
+template <size_t N, typename ElemType>
+class CompressedKDTree<N, ElemType>::BitReader {
+public:
+    explicit BitReader(const string& bytes) : bytes_(bytes), pos_(0), acc_(0), used_(0) {}
+
+    uint32_t read(size_t bits) {
+        while (used_ < bits) {
+            if (pos_ >= bytes_.size())
+                throw runtime_error("Truncated snapshot");
+            acc_ |= static_cast<uint64_t>(static_cast<unsigned char>(bytes_[pos_++])) << used_;
+            used_ += 8;
+        }
+        uint32_t value = static_cast<uint32_t>(acc_ & ((uint64_t(1) << bits) - 1));
+        acc_ >>= bits;
+        used_ -= bits;
+        return value;
+    }
+
+    void readBytes(void* data, size_t size) {
+        unsigned char *bytes = static_cast<unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i)
+            bytes[i] = static_cast<unsigned char>(read(8));
+    }
+
+private:
+    const string& bytes_;
+    size_t pos_;
+    uint64_t acc_;
+    size_t used_;
+};
+
+const char kSnapshotMagic[4] = {'K', 'D', 'T', 'S'};
+
+// Bits needed to store a splitting dimension
+template <size_t N, typename ElemType>
+size_t CompressedKDTree<N, ElemType>::axisBits() {
+    size_t bits = 0;
+    while ((size_t(1) << bits) < N)
+        ++bits;
+    return bits;
+}
+
+template <size_t N, typename ElemType>
+uint32_t CompressedKDTree<N, ElemType>::quantize(double x, double lo, double hi, size_t bits) {
+    if (!(hi > lo))
+        return 0;
+    double maxQ = static_cast<double>((uint64_t(1) << bits) - 1);
+    double q = floor((x - lo) / (hi - lo) * maxQ + 0.5);
+    return static_cast<uint32_t>(min(max(q, 0.0), maxQ));
+}
+
+template <size_t N, typename ElemType>
+double CompressedKDTree<N, ElemType>::dequantize(uint32_t q, double lo, double hi, size_t bits) {
+    if (!(hi > lo))
+        return lo;
+    double maxQ = static_cast<double>((uint64_t(1) << bits) - 1);
+    return lo + (hi - lo) * (q / maxQ);
+}
+
+// encodeNode writes one node and returns its decoded coordinates. The callers
+// split the cell at the decoded coordinate, not the original one, so that the
+// decoder derives exactly the same cells.
+template <size_t N, typename ElemType>
+void CompressedKDTree<N, ElemType>::encodeNode(BitWriter &out, const TreeNode *node, const Cell &cell,
+                                               size_t bits, Point<N> &decoded) {
+    out.write(node->left_ != NULL, 1);
+    out.write(node->right_ != NULL, 1);
+    out.write(static_cast<uint32_t>(node->axis_), axisBits());
+    for (size_t i = 0; i < N; ++i) {
+        uint32_t q = quantize(node->pt_[i], cell.lo[i], cell.hi[i], bits);
+        out.write(q, bits);
+        decoded[i] = dequantize(q, cell.lo[i], cell.hi[i], bits);
+    }
+    out.writeBytes(&node->value_, sizeof(ElemType));
+}
+
+template <size_t N, typename ElemType>
+void CompressedKDTree<N, ElemType>::encodeTopRe(BitWriter &out, const TreeNode *node, Cell cell,
+                                                size_t depth, size_t cutDepth, size_t bits,
+                                                vector< pair<const TreeNode*, Cell> > &blockRoots) {
+    if (depth == cutDepth) {
+        blockRoots.push_back(make_pair(node, cell));
+        return;
+    }
+
+    Point<N> decoded;
+    encodeNode(out, node, cell, bits, decoded);
+
+    size_t index = node->axis_;
+    if (node->left_ != NULL) {
+        Cell left = cell;
+        left.hi[index] = decoded[index];
+        encodeTopRe(out, node->left_, left, depth + 1, cutDepth, bits, blockRoots);
+    }
+    if (node->right_ != NULL) {
+        Cell right = cell;
+        right.lo[index] = decoded[index];
+        encodeTopRe(out, node->right_, right, depth + 1, cutDepth, bits, blockRoots);
+    }
+}
+
+template <size_t N, typename ElemType>
+void CompressedKDTree<N, ElemType>::encodeBlockRe(BitWriter &out, const TreeNode *node, Cell cell, size_t bits) {
+    Point<N> decoded;
+    encodeNode(out, node, cell, bits, decoded);
+
+    size_t index = node->axis_;
+    if (node->left_ != NULL) {
+        Cell left = cell;
+        left.hi[index] = decoded[index];
+        encodeBlockRe(out, node->left_, left, bits);
+    }
+    if (node->right_ != NULL) {
+        Cell right = cell;
+        right.lo[index] = decoded[index];
+        encodeBlockRe(out, node->right_, right, bits);
+    }
+}
+
+// save function
+template <size_t N, typename ElemType>
+void CompressedKDTree<N, ElemType>::save(const KDTree<N, ElemType> &tree, const string &path,
+                                         size_t bits, size_t blockNodes) {
+    if (bits < 1 || bits > 32)
+        throw out_of_range("Quantization bits must be between 1 and 32");
+
+    // The root cell is the bounding box of all points
+    Cell bounds;
+    for (size_t i = 0; i < N; ++i) {
+        bounds.lo[i] = tree.empty() ? 0.0 : numeric_limits<double>::infinity();
+        bounds.hi[i] = tree.empty() ? 0.0 : -numeric_limits<double>::infinity();
+    }
+    for (size_t n = 0; n < tree.nodes_.size(); ++n) {
+        for (size_t i = 0; i < N; ++i) {
+            bounds.lo[i] = min(bounds.lo[i], tree.nodes_[n]->pt_[i]);
+            bounds.hi[i] = max(bounds.hi[i], tree.nodes_[n]->pt_[i]);
+        }
+    }
+
+    // Cut so that a balanced tree gets blocks of about blockNodes nodes
+    uint32_t cutDepth = 0;
+    while ((tree.size() >> (cutDepth + 1)) >= max<size_t>(blockNodes, 1))
+        ++cutDepth;
+
+    BitWriter top;
+    vector< pair<const TreeNode*, Cell> > blockRoots;
+    if (tree.root_ != NULL)
+        encodeTopRe(top, tree.root_, bounds, 0, cutDepth, bits, blockRoots);
+
+    vector<uint64_t> offsets(1, 0);
+    string payload;
+    for (size_t b = 0; b < blockRoots.size(); ++b) {
+        BitWriter block;
+        encodeBlockRe(block, blockRoots[b].first, blockRoots[b].second, bits);
+        payload += block.finish();
+        offsets.push_back(payload.size());
+    }
+
+    ofstream out(path.c_str(), ios::binary);
+    const string& topBytes = top.finish();
+    uint32_t dim = N, bits32 = static_cast<uint32_t>(bits), valueSize = sizeof(ElemType);
+    uint64_t count = tree.size(), numBlocks = blockRoots.size(), topSize = topBytes.size();
+    out.write(kSnapshotMagic, 4);
+    out.write(reinterpret_cast<const char*>(&dim), sizeof(dim));
+    out.write(reinterpret_cast<const char*>(&bits32), sizeof(bits32));
+    out.write(reinterpret_cast<const char*>(&valueSize), sizeof(valueSize));
+    out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    out.write(reinterpret_cast<const char*>(&cutDepth), sizeof(cutDepth));
+    out.write(reinterpret_cast<const char*>(bounds.lo.begin()), N * sizeof(double));
+    out.write(reinterpret_cast<const char*>(bounds.hi.begin()), N * sizeof(double));
+    out.write(reinterpret_cast<const char*>(&numBlocks), sizeof(numBlocks));
+    out.write(reinterpret_cast<const char*>(&offsets[0]), offsets.size() * sizeof(uint64_t));
+    out.write(reinterpret_cast<const char*>(&topSize), sizeof(topSize));
+    out.write(topBytes.data(), topBytes.size());
+    out.write(payload.data(), payload.size());
+    if (!out)
+        throw runtime_error("Cannot write snapshot " + path);
+}
+
+// Construct function, reads the header and decodes the top
+template <size_t N, typename ElemType>
+CompressedKDTree<N, ElemType>::CompressedKDTree(const string &path) {
+    path_ = path;
+    maxCachedBlocks_ = numeric_limits<size_t>::max();
+
+    ifstream in(path.c_str(), ios::binary);
+    char magic[4];
+    uint32_t dim = 0, bits32 = 0, valueSize = 0, cutDepth = 0;
+    uint64_t count = 0, numBlocks = 0, topSize = 0;
+    in.read(magic, 4);
+    in.read(reinterpret_cast<char*>(&dim), sizeof(dim));
+    in.read(reinterpret_cast<char*>(&bits32), sizeof(bits32));
+    in.read(reinterpret_cast<char*>(&valueSize), sizeof(valueSize));
+    in.read(reinterpret_cast<char*>(&count), sizeof(count));
+    in.read(reinterpret_cast<char*>(&cutDepth), sizeof(cutDepth));
+    if (!in || memcmp(magic, kSnapshotMagic, 4) != 0)
+        throw runtime_error("Not a KDTree snapshot: " + path);
+    if (dim != N || valueSize != sizeof(ElemType) || bits32 < 1 || bits32 > 32)
+        throw runtime_error("Snapshot does not match this tree type: " + path);
+
+    in.read(reinterpret_cast<char*>(bounds_.lo.begin()), N * sizeof(double));
+    in.read(reinterpret_cast<char*>(bounds_.hi.begin()), N * sizeof(double));
+    in.read(reinterpret_cast<char*>(&numBlocks), sizeof(numBlocks));
+    blockOffsets_.resize(numBlocks + 1);
+    in.read(reinterpret_cast<char*>(&blockOffsets_[0]), blockOffsets_.size() * sizeof(uint64_t));
+    in.read(reinterpret_cast<char*>(&topSize), sizeof(topSize));
+    string topBytes(topSize, '\0');
+    in.read(&topBytes[0], topSize);
+    if (!in)
+        throw runtime_error("Truncated snapshot " + path);
+
+    bits_ = bits32;
+    count_ = count;
+    cutDepth_ = cutDepth;
+    payloadStart_ = static_cast<uint64_t>(in.tellg());
+
+    if (count_ > 0) {
+        BitReader reader(topBytes);
+        if (cutDepth_ == 0)
+            blockCells_.push_back(bounds_);
+        else
+            decodeTopRe(reader, bounds_, 0);
+    }
+    if (blockCells_.size() != numBlocks)
+        throw runtime_error("Corrupted snapshot " + path);
+}
+
+template <size_t N, typename ElemType>
+inline size_t CompressedKDTree<N, ElemType>::dimension() const {
+    return N;
+}
+
+template <size_t N, typename ElemType>
+inline size_t CompressedKDTree<N, ElemType>::size() const {
+    return count_;
+}
+
+template <size_t N, typename ElemType>
+inline bool CompressedKDTree<N, ElemType>::empty() const {
+    return size() == 0;
+}
+
+template <size_t N, typename ElemType>
+inline size_t CompressedKDTree<N, ElemType>::blocksLoaded() const {
+    return blocks_.size();
+}
+
+template <size_t N, typename ElemType>
+void CompressedKDTree<N, ElemType>::setMaxCachedBlocks(size_t maxBlocks) {
+    maxCachedBlocks_ = maxBlocks;
+}
+
+// decodeNode reads one node written by encodeNode
+template <size_t N, typename ElemType>
+void CompressedKDTree<N, ElemType>::decodeNode(BitReader &in, const Cell &cell, DecodedNode &node,
+                                               bool &hasLeft, bool &hasRight) const {
+    hasLeft = in.read(1);
+    hasRight = in.read(1);
+    node.axis_ = in.read(axisBits()) % N;
+    for (size_t i = 0; i < N; ++i)
+        node.pt_[i] = dequantize(in.read(bits_), cell.lo[i], cell.hi[i], bits_);
+    in.readBytes(&node.value_, sizeof(ElemType));
+    node.left_ = -1;
+    node.right_ = -1;
+}
+
+// decodeTopRe decodes the nodes above the cut and records the cell of every
+// block root in preorder, which is the order the blocks were written in
+template <size_t N, typename ElemType>
+long CompressedKDTree<N, ElemType>::decodeTopRe(BitReader &in, const Cell &cell, size_t depth) {
+    if (depth == cutDepth_) {
+        blockCells_.push_back(cell);
+        return -static_cast<long>(blockCells_.size()) - 1;
+    }
+
+    DecodedNode node;
+    bool hasLeft, hasRight;
+    decodeNode(in, cell, node, hasLeft, hasRight);
+    long index = top_.size();
+    top_.push_back(node);
+
+    size_t axis = node.axis_;
+    if (hasLeft) {
+        Cell left = cell;
+        left.hi[axis] = node.pt_[axis];
+        long child = decodeTopRe(in, left, depth + 1);
+        top_[index].left_ = child;
+    }
+    if (hasRight) {
+        Cell right = cell;
+        right.lo[axis] = node.pt_[axis];
+        long child = decodeTopRe(in, right, depth + 1);
+        top_[index].right_ = child;
+    }
+    return index;
+}
+
+template <size_t N, typename ElemType>
+long CompressedKDTree<N, ElemType>::decodeBlockRe(BitReader &in, const Cell &cell,
+                                                  vector<DecodedNode> &nodes) const {
+    DecodedNode node;
+    bool hasLeft, hasRight;
+    decodeNode(in, cell, node, hasLeft, hasRight);
+    long index = nodes.size();
+    nodes.push_back(node);
+
+    size_t axis = node.axis_;
+    if (hasLeft) {
+        Cell left = cell;
+        left.hi[axis] = node.pt_[axis];
+        long child = decodeBlockRe(in, left, nodes);
+        nodes[index].left_ = child;
+    }
+    if (hasRight) {
+        Cell right = cell;
+        right.lo[axis] = node.pt_[axis];
+        long child = decodeBlockRe(in, right, nodes);
+        nodes[index].right_ = child;
+    }
+    return index;
+}
+
+// block function, reads and decodes a block the first time it is needed
+template <size_t N, typename ElemType>
+const vector<typename CompressedKDTree<N, ElemType>::DecodedNode>&
+CompressedKDTree<N, ElemType>::block(size_t index) const {
+    typename map<size_t, vector<DecodedNode> >::iterator found = blocks_.find(index);
+    if (found != blocks_.end())
+        return found->second;
+
+    string bytes(blockOffsets_[index + 1] - blockOffsets_[index], '\0');
+    ifstream in(path_.c_str(), ios::binary);
+    in.seekg(payloadStart_ + blockOffsets_[index]);
+    in.read(&bytes[0], bytes.size());
+    if (!in)
+        throw runtime_error("Truncated snapshot " + path_);
+
+    vector<DecodedNode>& nodes = blocks_[index];
+    BitReader reader(bytes);
+    decodeBlockRe(reader, blockCells_[index], nodes);
+    return nodes;
+}
+
+// kNNValueRe function, the same search as KDTree::kNNValueRe that follows
+// block references out of the top
+template <size_t N, typename ElemType>
+void CompressedKDTree<N, ElemType>::kNNValueRe(const Point<N> &pt, BoundedPQueue<const DecodedNode*> &bpq,
+                                               const vector<DecodedNode> &nodes, long index) const {
+    if (index == -1)
+        return ;
+    if (index <= -2) {
+        kNNValueRe(pt, bpq, block(-index - 2), 0);
+        return ;
+    }
+
+    const DecodedNode &current_node = nodes[index];
+    bpq.enqueue(&current_node, Distance(current_node.pt_, pt));
+
+    size_t axis = current_node.axis_;
+    bool goLeft = pt[axis] < current_node.pt_[axis];
+    kNNValueRe(pt, bpq, nodes, goLeft ? current_node.left_ : current_node.right_);
+    if (bpq.size() != bpq.maxSize() || fabs(pt[axis] - current_node.pt_[axis]) < bpq.worst())
+        kNNValueRe(pt, bpq, nodes, goLeft ? current_node.right_ : current_node.left_);
+}
+
+// kNNValue function
+template <size_t N, typename ElemType>
+ElemType CompressedKDTree<N, ElemType>::kNNValue(const Point<N> &key, size_t k) const {
+    if (blocks_.size() > maxCachedBlocks_)
+        blocks_.clear();
+
+    BoundedPQueue<const DecodedNode*> bpq(k);
+    if (count_ > 0)
+        kNNValueRe(key, bpq, top_, cutDepth_ == 0 ? -2 : 0);
+
+    vector<ElemType> kValues;
+    while (!bpq.empty())
+        kValues.push_back(bpq.dequeueMin()->value_);
+
+    return KDTree<N, ElemType>::majorityValue(kValues);
+}
+
+// decompress function
+template <size_t N, typename ElemType>
+KDTree<N, ElemType> CompressedKDTree<N, ElemType>::decompress() const {
+    vector< pair<Point<N>, ElemType> > entries;
+    entries.reserve(count_);
+    for (size_t i = 0; i < top_.size(); ++i)
+        entries.push_back(make_pair(top_[i].pt_, top_[i].value_));
+    for (size_t b = 0; b < blockCells_.size(); ++b) {
+        const vector<DecodedNode>& nodes = block(b);
+        for (size_t i = 0; i < nodes.size(); ++i)
+            entries.push_back(make_pair(nodes[i].pt_, nodes[i].value_));
+    }
+
+    return KDTree<N, ElemType>(entries.begin(), entries.end());
+}
+
+#endif // COMPRESSED_KDTREE_INCLUDED
@@ -0,0 +1,229 @@
+/**
+ * File: KDForest.h
+ * Author: Zach Gu
+ * ------------------------
+ * An interface representing a forest of randomized kd-trees for approximate
+ * nearest neighbor search in high dimensions. Every tree is a KDTree whose
+ * nodes split on a dimension picked at random among the ones with the largest
+ * variance, so the trees partition the space differently. A query walks all
+ * the trees at once in best-bin-first order: one priority queue holds the
+ * unexplored branches of every tree, ordered by their distance to the query,
+ * and the search stops after a fixed number of points has been checked.
+ */
+
+#ifndef KDFOREST_INCLUDED
+#define KDFOREST_INCLUDED
+
+#include "KDTree.h"
+#include <functional>
+#include <queue>
+#include <random>
+#include <unordered_set>
+
+template <size_t N, typename ElemType>
+class KDForest {
+public:
+    // Constructor: KDForest(InputIterator begin, InputIterator end,
+    //                       size_t numTrees = 4, unsigned seed = 0);
+    // Usage: KDForest<32, int> forest(points.begin(), points.end(), 8);
+    // ----------------------------------------------------
+    // Builds numTrees randomized trees from a range of pair<Point<N>, ElemType>.
+    // If a point occurs more than once, the last value wins. The same seed
+    // always gives the same forest.
+    template <typename InputIterator>
+    KDForest(InputIterator begin, InputIterator end, size_t numTrees = 4, unsigned seed = 0);
+
+    // Destructor: ~KDForest()
+    // Usage: (implicit)
+    // ----------------------------------------------------
+    // Cleans up all resources used by the KDForest.
+    ~KDForest();
+
+    KDForest(const KDForest& rhs) = delete;
+    KDForest& operator=(const KDForest& rhs) = delete;
+
+    // size_t dimension() const;
+    // size_t size() const;
+    // bool empty() const;
+    // size_t numTrees() const;
+    // Usage: if (forest.empty())
+    // ----------------------------------------------------
+    // Returns the dimension of the points, the number of distinct points,
+    // whether the forest is empty and the number of trees, respectively.
+    size_t dimension() const;
+    size_t size() const;
+    bool empty() const;
+    size_t numTrees() const;
+
+    // ElemType kNNValue(const Point<N>& key, size_t k, size_t maxChecks) const;
+    // Usage: cout << forest.kNNValue(v, 3, 256) << endl;
+    // ----------------------------------------------------
+    // Approximates KDTree::kNNValue: finds k points near v and returns the
+    // most common value among them, checking at most maxChecks points (more
+    // if fewer than k have been found by then). More checks give better
+    // recall; with maxChecks >= size() the answer is exact.
+    ElemType kNNValue(const Point<N>& key, size_t k, size_t maxChecks) const;
+
+private:
+    // The trees map each point to the index of its value in values_, so
+    // that the same point reached through different trees is seen only once
+    typedef KDTree<N, size_t> Tree;
+    typedef typename Tree::Node TreeNode;
+
+    // Splitting rule picking one of the top-variance dimensions at random
+    struct RandomAxis {
+        std::mt19937 *rng;
+
+        template <typename Entry>
+        size_t operator()(const Entry* first, const Entry* last, size_t level);
+    };
+
+    vector<ElemType> values_;
+    vector<Tree*> trees_;
+};
+
+/** KDForest class implementation details */
+
+// Number of points sampled to estimate the variances
+const size_t kForestVarianceSample = 100;
+
+// Number of highest-variance dimensions the random split chooses from
+const size_t kForestTopAxes = 5;
+
+// Construct function. The search walks the nodes of the trees only, so
+// they are built without the point copies of the linear scan.
+template <size_t N, typename ElemType>
+template <typename InputIterator>
+KDForest<N, ElemType>::KDForest(InputIterator begin, InputIterator end, size_t numTrees, unsigned seed) {
+    vector< pair<Point<N>, size_t> > entries;
+    for (; begin != end; ++begin) {
+        entries.push_back(make_pair(begin->first, values_.size()));
+        values_.push_back(begin->second);
+    }
+
+    std::mt19937 rng(seed);
+    RandomAxis chooser = {&rng};
+    typename Tree::WithoutScan withoutScan;
+    for (size_t i = 0; i < max<size_t>(numTrees, 1); ++i)
+        trees_.push_back(new Tree(entries.begin(), entries.end(), chooser, withoutScan));
+}
+
+// Destructor function
+template <size_t N, typename ElemType>
+KDForest<N, ElemType>::~KDForest() {
+    for (size_t i = 0; i < trees_.size(); ++i)
+        delete trees_[i];
+}
+
+template <size_t N, typename ElemType>
+inline size_t KDForest<N, ElemType>::dimension() const {
+    return N;
+}
+
+// Every tree holds the same distinct points
+template <size_t N, typename ElemType>
+inline size_t KDForest<N, ElemType>::size() const {
+    return trees_[0]->size();
+}
+
+template <size_t N, typename ElemType>
+inline bool KDForest<N, ElemType>::empty() const {
+    return size() == 0;
+}
+
+template <size_t N, typename ElemType>
+inline size_t KDForest<N, ElemType>::numTrees() const {
+    return trees_.size();
+}
+
+// RandomAxis estimates the variance of every dimension from a strided sample
+// of the subtree, then picks one of the kForestTopAxes largest at random
+template <size_t N, typename ElemType>
+template <typename Entry>
+size_t KDForest<N, ElemType>::RandomAxis::operator()(const Entry *first, const Entry *last, size_t) {
+    size_t count = last - first;
+    size_t stride = max<size_t>(count / kForestVarianceSample, 1);
+
+    double mean[N], variance[N];
+    fill(mean, mean + N, 0.0);
+    fill(variance, variance + N, 0.0);
+    size_t samples = 0;
+    for (const Entry *it = first; it < last; it += stride, ++samples) {
+        for (size_t i = 0; i < N; ++i)
+            mean[i] += it->first[i];
+    }
+    for (size_t i = 0; i < N; ++i)
+        mean[i] /= samples;
+    for (const Entry *it = first; it < last; it += stride) {
+        for (size_t i = 0; i < N; ++i)
+            variance[i] += (it->first[i] - mean[i]) * (it->first[i] - mean[i]);
+    }
+
+    size_t axes[N];
+    for (size_t i = 0; i < N; ++i)
+        axes[i] = i;
+    size_t top = min(kForestTopAxes, N);
+    partial_sort(axes, axes + top, axes + N,
+                 [&variance](size_t a, size_t b) { return variance[a] > variance[b]; });
+
+    return axes[std::uniform_int_distribution<size_t>(0, top - 1)(*rng)];
+}
+
+// kNNValue function, best-bin-first search over all trees. Priorities are
+// squared distances; a branch's priority is a lower bound on the distance
+// from the query to any point in it.
+template <size_t N, typename ElemType>
+ElemType KDForest<N, ElemType>::kNNValue(const Point<N> &key, size_t k, size_t maxChecks) const {
+    if (k == 0)
+        return ElemType();
+
+    typedef pair<double, const TreeNode*> Branch;
+    priority_queue<Branch, vector<Branch>, greater<Branch> > branches;
+    for (size_t i = 0; i < trees_.size(); ++i) {
+        if (trees_[i]->root_ != NULL)
+            branches.push(Branch(0.0, trees_[i]->root_));
+    }
+
+    BoundedPQueue<size_t> bpq(k);
+    unordered_set<size_t> checked;
+    checked.reserve(2 * maxChecks);
+    size_t checks = 0;
+    while (!branches.empty()) {
+        Branch branch = branches.top();
+        branches.pop();
+
+        bool full = bpq.size() == bpq.maxSize();
+        if (full && (branch.first >= bpq.worst() || checks >= maxChecks))
+            break;
+
+        // Descend to a leaf, queueing the far side of every split
+        for (const TreeNode *node = branch.second; node != NULL; ) {
+            if (checked.insert(node->value_).second) {
+                double dist = 0.0;
+                for (size_t i = 0; i < N; ++i)
+                    dist += (node->pt_[i] - key[i]) * (node->pt_[i] - key[i]);
+                if (bpq.size() != bpq.maxSize() || dist < bpq.worst())
+                    bpq.enqueue(node->value_, dist);
+                ++checks;
+            }
+
+            size_t index = node->axis_;
+            double diff = key[index] - node->pt_[index];
+            const TreeNode *nearChild = diff < 0 ? node->left_ : node->right_;
+            const TreeNode *farChild = diff < 0 ? node->right_ : node->left_;
+            double bound = max(branch.first, diff * diff);
+            if (farChild != NULL && (bpq.size() != bpq.maxSize() || bound < bpq.worst()))
+                branches.push(Branch(bound, farChild));
+
+            node = nearChild;
+        }
+    }
+
+    vector<ElemType> kValues;
+    while (!bpq.empty())
+        kValues.push_back(values_[bpq.dequeueMin()]);
+
+    return KDTree<N, ElemType>::majorityValue(kValues);
+}
+
+#endif // KDFOREST_INCLUDED
@@ -15,6 +15,9 @@
 #include <stdexcept>
 #include <cmath>
 #include <set>
+#include <vector>
+#include <utility>
+#include <algorithm>
 
 // "using namespace" in a header file is conventionally frowned upon, but I'm
 // including it here so that you may use things like size_t without having to
@@ -29,6 +32,27 @@ public:
     // ----------------------------------------------------
     // Constructs an empty KDTree.
     KDTree();
+
+    // template <typename InputIterator>
+    // KDTree(InputIterator begin, InputIterator end);
+    // Usage: KDTree<3, int> myTree(points.begin(), points.end());
+    // ----------------------------------------------------
+    // Constructs a balanced KDTree from a range of pair<Point<N>, ElemType>
+    // by splitting every level at its median. If a point occurs more than
+    // once, the last value wins, just as with repeated calls to insert.
+    template <typename InputIterator>
+    KDTree(InputIterator begin, InputIterator end);
+
+    // template <typename InputIterator, typename AxisChooser>
+    // KDTree(InputIterator begin, InputIterator end, AxisChooser chooseAxis);
+    // Usage: KDTree<3, int> myTree(points.begin(), points.end(), chooser);
+    // ----------------------------------------------------
+    // Like the constructor above, but the splitting dimension of every node
+    // is picked by calling chooseAxis(first, last, level), where [first, last)
+    // are the (point, value) pairs of the node's subtree. This is how the
+    // randomized trees of a KDForest are built.
+    template <typename InputIterator, typename AxisChooser>
+    KDTree(InputIterator begin, InputIterator end, AxisChooser chooseAxis);
     
     // Destructor: ~KDTree()
     // Usage: (implicit)
@@ -98,8 +122,25 @@ public:
     // nearest to v and returns the most common value associated with those
     // points. In the event of a tie, one of the most frequent value will be
     // chosen.
+    //
+    // When the tree is too small relative to its dimension for the splitting
+    // planes to prune anything (roughly size() < 2^N, which is always the case
+    // for high-dimensional data), the query is answered with a blocked linear
+    // scan over the contiguous point storage instead of walking the tree.
     ElemType kNNValue(const Point<N>& key, size_t k) const;
 
+    // class QueryScratch;
+    // ElemType kNNValue(const Point<N>& key, size_t k, QueryScratch& scratch) const
+    // Usage: KDTree<3, int>::QueryScratch scratch;
+    //        cout << kd.kNNValue(v, 3, scratch) << endl;
+    // ----------------------------------------------------
+    // Same as above, but keeps the neighbor, value and heap vectors in scratch
+    // instead of allocating them for every query, so a thread answering many
+    // queries should keep one scratch and pass it to each of them. A scratch
+    // must not be shared by queries running at the same time.
+    class QueryScratch;
+    ElemType kNNValue(const Point<N>& key, size_t k, QueryScratch& scratch) const;
+
 
 private:
     // TODO: Add implementation details here.
@@ -108,6 +149,7 @@ private:
         Point<N> pt_;    // Point
         ElemType value_; // Value, mapped with Point
         size_t level_;   // Level of the node
+        size_t axis_;    // Splitting dimension of the node
 
         Node *left_;     // Left sub tree
         Node *right_;    // Right sub tree
@@ -117,7 +159,41 @@ private:
 
     size_t size_;
 
+    // Contiguous copy of every point for the linear-scan path. Points are
+    // grouped in blocks of kScanBlock; inside a block the coordinates are
+    // stored dimension by dimension, so that the distance loop runs over
+    // consecutive points and can be vectorized by the compiler.
+    static const size_t kScanBlock = 32;
+    vector<double> coords_;
+    vector<Node*> nodes_;   // nodes_[i] owns the i-th point of coords_
+
 private:
+    // A (point, value) pair used by the bulk construction
+    typedef pair<Point<N>, ElemType> Entry;
+
+    // Tag of the constructor that leaves out the linear-scan storage
+    struct WithoutScan {};
+
+    // Bulk construction without the linear-scan storage, for the trees of a
+    // KDForest, which only ever walk their nodes. kNNValue on such a tree
+    // always walks it too.
+    template <typename InputIterator, typename AxisChooser>
+    KDTree(InputIterator begin, InputIterator end, AxisChooser chooseAxis, WithoutScan);
+
+    // The default splitting rule, cycling through the dimensions
+    struct CycleAxis {
+        size_t operator()(const Entry*, const Entry*, size_t level) const { return level % N; }
+    };
+
+    //A helper function to sort out duplicated points and build the tree,
+    //with the linear-scan storage if withScan is set
+    template <typename AxisChooser>
+    void build(vector<Entry>& entries, AxisChooser chooseAxis, bool withScan);
+
+    //A helper function to recursively build a balanced tree
+    template <typename AxisChooser>
+    Node *buildRe(vector<Entry>& entries, size_t lo, size_t hi, size_t level, AxisChooser& chooseAxis);
+
     //A helper function to find node
     Node* findNode(const Point<N>& pt) const;
 
@@ -130,11 +206,47 @@ private:
     // kNNValueRecursion function
     void kNNValueRe(const Point<N>& pt, BoundedPQueue<Node*>& bpq, Node* current_node) const;
 
+    // Cost model deciding between the tree walk and the linear scan
+    bool preferLinearScan() const;
+
+    // A (squared distance, index into nodes_) pair kept by the linear scan
+    typedef pair<double, size_t> Candidate;
+
+    // A helper function to find the k nearest nodes with a linear scan
+    void kNNScan(const Point<N>& pt, size_t k, vector<const Node*>& nearest) const;
+    void kNNScan(const Point<N>& pt, size_t k, vector<Candidate>& heap,
+                 vector<const Node*>& nearest) const;
+
+    // A helper function to append a node to the contiguous storage
+    void appendScan(Node *node);
+
+    // A helper function to rebuild the contiguous storage from the tree
+    void indexRe(Node *current_node);
+
+    // A helper function to pick the most common value, sorts kValues
+    static ElemType majorityValue(vector<ElemType>& kValues);
+
+    // KDForest, LogKDTree and CompressedKDTree work on the nodes directly
+    template <size_t M, typename T> friend class KDForest;
+    template <size_t M, typename T> friend class LogKDTree;
+    template <size_t M, typename T> friend class CompressedKDTree;
+
 };
 
 /** KDTree class implementation details */
 // TODO: finish the implementation of the rest of the KDTree class
 
+// The working vectors of one query, cleared but not freed between queries
+template <size_t N, typename ElemType>
+class KDTree<N, ElemType>::QueryScratch {
+private:
+    vector<const Node*> nearest_;
+    vector<ElemType> kValues_;
+    vector<Candidate> heap_;
+
+    friend class KDTree;
+};
+
 // Construct function
 template <size_t N, typename ElemType>
 KDTree<N, ElemType>::KDTree() {
@@ -143,6 +255,94 @@ KDTree<N, ElemType>::KDTree() {
     root_ = NULL;
 }
 
+// Bulk construction, sorts the entries to drop duplicated points and then
+// builds the tree top-down
+template <size_t N, typename ElemType>
+template <typename InputIterator>
+KDTree<N, ElemType>::KDTree(InputIterator begin, InputIterator end) {
+    vector<Entry> entries(begin, end);
+    build(entries, CycleAxis(), true);
+}
+
+// Bulk construction with a custom splitting rule
+template <size_t N, typename ElemType>
+template <typename InputIterator, typename AxisChooser>
+KDTree<N, ElemType>::KDTree(InputIterator begin, InputIterator end, AxisChooser chooseAxis) {
+    vector<Entry> entries(begin, end);
+    build(entries, chooseAxis, true);
+}
+
+// Bulk construction with a custom splitting rule and no linear-scan storage
+template <size_t N, typename ElemType>
+template <typename InputIterator, typename AxisChooser>
+KDTree<N, ElemType>::KDTree(InputIterator begin, InputIterator end, AxisChooser chooseAxis,
+                            WithoutScan) {
+    vector<Entry> entries(begin, end);
+    build(entries, chooseAxis, false);
+}
+
+// A helper function to sort out duplicated points and build the tree
+template <size_t N, typename ElemType>
+template <typename AxisChooser>
+void KDTree<N, ElemType>::build(vector<Entry> &entries, AxisChooser chooseAxis, bool withScan) {
+    // Keep only the last value of every repeated point
+    auto lessPoint = [](const Entry& a, const Entry& b) {
+        return lexicographical_compare(a.first.begin(), a.first.end(),
+                                       b.first.begin(), b.first.end());
+    };
+    stable_sort(entries.begin(), entries.end(), lessPoint);
+    size_t unique = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (i + 1 < entries.size() && entries[i].first == entries[i + 1].first)
+            continue;
+        entries[unique++] = entries[i];
+    }
+    entries.resize(unique);
+
+    size_ = entries.size();
+    root_ = buildRe(entries, 0, entries.size(), 0, chooseAxis);
+    if (!withScan)
+        return ;
+    coords_.reserve(((size_ + kScanBlock - 1) / kScanBlock) * kScanBlock * N);
+    nodes_.reserve(size_);
+    indexRe(root_);
+}
+
+// A helper function to build the subtree of entries[lo, hi). The median is
+// moved to the first entry with the median coordinate, so that everything on
+// its left is strictly smaller, matching the rule used by insert and findNode.
+template <size_t N, typename ElemType>
+template <typename AxisChooser>
+typename KDTree<N, ElemType>::Node* KDTree<N, ElemType>::buildRe(vector<Entry> &entries, size_t lo,
+                                                                 size_t hi, size_t level,
+                                                                 AxisChooser &chooseAxis) {
+    if (lo >= hi)
+        return NULL;
+
+    size_t index = chooseAxis(&entries[0] + lo, &entries[0] + hi, level) % N;
+    auto lessCoord = [index](const Entry& a, const Entry& b) {
+        return a.first[index] < b.first[index];
+    };
+    size_t mid = lo + (hi - lo) / 2;
+    nth_element(entries.begin() + lo, entries.begin() + mid, entries.begin() + hi, lessCoord);
+
+    double median = entries[mid].first[index];
+    size_t split = partition(entries.begin() + lo, entries.begin() + mid,
+                             [index, median](const Entry& e) { return e.first[index] < median; })
+                   - entries.begin();
+    swap(entries[split], entries[mid]);
+
+    Node *node = new Node;
+    node->pt_ = entries[split].first;
+    node->value_ = entries[split].second;
+    node->level_ = level;
+    node->axis_ = index;
+    node->left_ = buildRe(entries, lo, split, level + 1, chooseAxis);
+    node->right_ = buildRe(entries, split + 1, hi, level + 1, chooseAxis);
+
+    return node;
+}
+
 // Desstructor function
 template <size_t N, typename ElemType>
 KDTree<N, ElemType>::~KDTree() {
@@ -156,6 +356,7 @@ template <size_t N, typename ElemType>
 KDTree<N, ElemType>::KDTree(const KDTree &other) {
     size_ = other.size();
     root_ = copyRe(other.root_);
+    indexRe(root_);
 }
 
 
@@ -165,6 +366,9 @@ KDTree<N, ElemType> &KDTree<N, ElemType>::operator =(const KDTree & other) {
         deleteRe(root_);
         root_ = copyRe(other.root_);
         size_ = other.size();
+        coords_.clear();
+        nodes_.clear();
+        indexRe(root_);
     }
 
     return *this;
@@ -207,7 +411,7 @@ void KDTree<N, ElemType>::insert(const Point<N> &pt,
         }
 
         // Determine which subtree to search
-        size_t index = current_node->level_ % N;
+        size_t index = current_node->axis_;
 
         parent_node = current_node;
         if(pt[index] < current_node->pt_[index]) {
@@ -224,14 +428,16 @@ void KDTree<N, ElemType>::insert(const Point<N> &pt,
     node->pt_ = pt;
     node->value_ = value;
     node->level_ = level;
+    node->axis_ = level % N;
     node->left_ = NULL;
     node->right_ = NULL;
     ++size_;
+    appendScan(node);
 
     if (current_node == root_) {
         root_ = node;
     }
-    else if (parent_node->pt_[parent_node->level_ % N] > pt[parent_node->level_ % N]) {
+    else if (parent_node->pt_[parent_node->axis_] > pt[parent_node->axis_]) {
         parent_node->left_ = node;
     }
     else {
@@ -248,7 +454,7 @@ typename KDTree<N, ElemType>::Node* KDTree<N, ElemType>::findNode(const Point<N>
             return current_node;
 
         // Continue to search sub trees
-        size_t index = current_node->level_ % N;
+        size_t index = current_node->axis_;
         if (current_node->pt_[index] > pt[index]) {
             current_node = current_node->left_;
         }
@@ -268,6 +474,7 @@ typename KDTree<N, ElemType>::Node* KDTree<N, ElemType>::copyRe(const Node *curr
     copy_node->pt_ = current_node->pt_;
     copy_node->value_ = current_node->value_;
     copy_node->level_ = current_node->level_;
+    copy_node->axis_ = current_node->axis_;
     copy_node->left_ = copyRe(current_node->left_);
     copy_node->right_ = copyRe(current_node->right_);
 
@@ -332,24 +539,149 @@ const ElemType &KDTree<N, ElemType>::at(const Point<N> &pt) const {
         throw out_of_range("This point doesn't exist!");
 }
 
+template <size_t N, typename ElemType>
+const size_t KDTree<N, ElemType>::kScanBlock;
+
+// A helper function to append a node to the contiguous storage
+template <size_t N, typename ElemType>
+void KDTree<N, ElemType>::appendScan(Node *node) {
+    size_t index = nodes_.size();
+    size_t lane = index % kScanBlock;
+
+    // Open a new, zero-padded block when the last one is full
+    if (lane == 0)
+        coords_.resize(coords_.size() + kScanBlock * N, 0.0);
+
+    double *block = &coords_[(index / kScanBlock) * kScanBlock * N];
+    for (size_t i = 0; i < N; ++i)
+        block[i * kScanBlock + lane] = node->pt_[i];
+
+    nodes_.push_back(node);
+}
+
+// A helper function to rebuild the contiguous storage from the tree
+template <size_t N, typename ElemType>
+void KDTree<N, ElemType>::indexRe(Node *current_node) {
+    if (current_node == NULL)
+        return ;
+
+    appendScan(current_node);
+    indexRe(current_node->left_);
+    indexRe(current_node->right_);
+}
+
+// A kd-tree only prunes well when it holds many more points than the 2^N
+// cells its splitting planes carve out; below that the recursion visits
+// nearly every node through pointer chasing and a flat scan is cheaper.
+// Trees built without the scan storage always walk.
+template <size_t N, typename ElemType>
+bool KDTree<N, ElemType>::preferLinearScan() const {
+    const double kPruningFactor = 4.0;
+    if (nodes_.size() != size_)
+        return false;
+    return static_cast<double>(size_) < kPruningFactor * ldexp(1.0, static_cast<int>(N));
+}
+
+// kNNScan function with a heap of its own
+template <size_t N, typename ElemType>
+void KDTree<N, ElemType>::kNNScan(const Point<N> &pt, size_t k, vector<const Node*> &nearest) const {
+    vector<Candidate> heap;
+    kNNScan(pt, k, heap, nearest);
+}
+
+// kNNScan function, computes the squared distances block by block and keeps
+// the k best nodes in a max-heap
+template <size_t N, typename ElemType>
+void KDTree<N, ElemType>::kNNScan(const Point<N> &pt, size_t k, vector<Candidate> &heap,
+                                  vector<const Node*> &nearest) const {
+    heap.clear();
+    if (k == 0)
+        return ;
+    heap.reserve(min(k, size_));
+
+    double dists[kScanBlock];
+    for (size_t base = 0; base < size_; base += kScanBlock) {
+        const double *block = &coords_[base * N];
+        for (size_t lane = 0; lane < kScanBlock; ++lane)
+            dists[lane] = 0.0;
+
+        for (size_t i = 0; i < N; ++i) {
+            const double *column = block + i * kScanBlock;
+            double coord = pt[i];
+            for (size_t lane = 0; lane < kScanBlock; ++lane) {
+                double diff = column[lane] - coord;
+                dists[lane] += diff * diff;
+            }
+        }
+
+        size_t count = min(kScanBlock, size_ - base);
+        for (size_t lane = 0; lane < count; ++lane) {
+            if (heap.size() < k) {
+                heap.push_back(make_pair(dists[lane], base + lane));
+                push_heap(heap.begin(), heap.end());
+            }
+            else if (dists[lane] < heap.front().first) {
+                pop_heap(heap.begin(), heap.end());
+                heap.back() = make_pair(dists[lane], base + lane);
+                push_heap(heap.begin(), heap.end());
+            }
+        }
+    }
+
+    sort_heap(heap.begin(), heap.end());
+    for (size_t i = 0; i < heap.size(); ++i)
+        nearest.push_back(nodes_[heap[i].second]);
+}
+
 // kNNValue function
 template <size_t N, typename ElemType>
 ElemType KDTree<N, ElemType>::kNNValue(const Point<N> &key, size_t k) const {
-    BoundedPQueue<Node*> bpq(k);
-    kNNValueRe(key, bpq, root_);
+    QueryScratch scratch;
+    return kNNValue(key, k, scratch);
+}
 
-    std::multiset<ElemType> kValues;
-    while (!bpq.empty()) {
-        kValues.insert(bpq.dequeueMin()->value_);
+// kNNValue function, reusing the vectors of scratch. The tree walk still
+// allocates in its BoundedPQueue.
+template <size_t N, typename ElemType>
+ElemType KDTree<N, ElemType>::kNNValue(const Point<N> &key, size_t k, QueryScratch &scratch) const {
+    vector<const Node*> &nearest = scratch.nearest_;
+    nearest.clear();
+    if (preferLinearScan()) {
+        kNNScan(key, k, scratch.heap_, nearest);
+    }
+    else {
+        BoundedPQueue<Node*> bpq(k);
+        kNNValueRe(key, bpq, root_);
+        while (!bpq.empty())
+            nearest.push_back(bpq.dequeueMin());
     }
 
-    ElemType most_freq;
+    vector<ElemType> &kValues = scratch.kValues_;
+    kValues.clear();
+    for (size_t i = 0; i < nearest.size(); ++i)
+        kValues.push_back(nearest[i]->value_);
+
+    return majorityValue(kValues);
+}
+
+// majorityValue function, returns the most frequent value
+// Sorting the values groups equal ones into runs; on a tie the smallest value
+// wins.
+template <size_t N, typename ElemType>
+ElemType KDTree<N, ElemType>::majorityValue(vector<ElemType> &kValues) {
+    sort(kValues.begin(), kValues.end());
+
+    ElemType most_freq = ElemType();
     size_t count = 0;
-    for (auto it = kValues.begin(), ie = kValues.end(); it != ie; it++) {
-        if (kValues.count(*it) > count) {
-            most_freq = *it;
-            count = kValues.count(*it);
+    for (size_t i = 0; i < kValues.size(); ) {
+        size_t j = i + 1;
+        while (j < kValues.size() && !(kValues[i] < kValues[j]))
+            ++j;
+        if (j - i > count) {
+            most_freq = kValues[i];
+            count = j - i;
         }
+        i = j;
     }
 
     return most_freq;
@@ -366,7 +698,7 @@ void KDTree<N, ElemType>::kNNValueRe(const Point<N> &pt, BoundedPQueue<Node *> &
     bpq.enqueue(current_node, Distance(current_node->pt_, pt));
 
     // Recursively search the half of the tree that contains the point
-    size_t index = current_node->level_ % N;
+    size_t index = current_node->axis_;
     if (pt[index] < current_node->pt_[index]) {
         kNNValueRe(pt, bpq, current_node->left_);
         // If the candiate hypersphere crosses this splitting plane,
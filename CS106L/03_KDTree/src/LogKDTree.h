@@ -0,0 +1,240 @@
+/**
+ * File: LogKDTree.h
+ * Author: Zach Gu
+ * ------------------------
+ * An interface representing a dynamic kd-tree built with the logarithmic
+ * method (Bentley and Saxe). Instead of inserting every point into one
+ * pointer tree, which unbalances it, the container keeps
+ *
+ *   - a small buffer tree that takes the new points, and
+ *   - a list of levels, where level i is either empty or a balanced,
+ *     bulk-built KDTree of exactly bufferSize * 2^i points.
+ *
+ * When the buffer is full it is merged with levels 0..j-1 into the first
+ * empty level j, like carrying in a binary counter. Every point is rebuilt
+ * O(log n) times, so an insert costs O(log^2 n) amortized, while queries
+ * search O(log n) balanced trees sharing one bound on the k-th distance.
+ */
+
+#ifndef LOG_KDTREE_INCLUDED
+#define LOG_KDTREE_INCLUDED
+
+#include "KDTree.h"
+
+template <size_t N, typename ElemType>
+class LogKDTree {
+public:
+    // Constructor: LogKDTree(size_t bufferSize = 256);
+    // Usage: LogKDTree<3, int> myTree;
+    // ----------------------------------------------------
+    // Constructs an empty LogKDTree whose buffer holds bufferSize points.
+    explicit LogKDTree(size_t bufferSize = 256);
+
+    // Destructor: ~LogKDTree()
+    // Usage: (implicit)
+    // ----------------------------------------------------
+    // Cleans up all resources used by the LogKDTree.
+    ~LogKDTree();
+
+    LogKDTree(const LogKDTree& rhs) = delete;
+    LogKDTree& operator=(const LogKDTree& rhs) = delete;
+
+    // size_t dimension() const;
+    // size_t size() const;
+    // bool empty() const;
+    // Usage: if (kd.empty())
+    // ----------------------------------------------------
+    // Returns the dimension of the points, the number of points and whether
+    // the container is empty, respectively.
+    size_t dimension() const;
+    size_t size() const;
+    bool empty() const;
+
+    // size_t numLevels() const;
+    // Usage: size_t levels = kd.numLevels();
+    // ----------------------------------------------------
+    // Returns the number of non-empty bulk-built levels.
+    size_t numLevels() const;
+
+    // bool contains(const Point<N>& pt) const;
+    // Usage: if (kd.contains(pt))
+    // ----------------------------------------------------
+    // Returns whether the specified point is contained in the LogKDTree.
+    bool contains(const Point<N>& pt) const;
+
+    // void insert(const Point<N>& pt, const ElemType& value);
+    // Usage: kd.insert(v, "This value is associated with v.");
+    // ----------------------------------------------------
+    // Inserts the point pt, associating it with the specified value. If the
+    // point already existed, the new value overwrites the existing one.
+    void insert(const Point<N>& pt, const ElemType& value);
+
+    // const ElemType& at(const Point<N>& pt) const;
+    // Usage: cout << kd.at(v) << endl;
+    // ----------------------------------------------------
+    // Returns a reference to the value associated with the point pt. If the
+    // point is not in the container, this function throws out_of_range.
+    const ElemType& at(const Point<N>& pt) const;
+
+    // ElemType kNNValue(const Point<N>& key, size_t k) const
+    // Usage: cout << kd.kNNValue(v, 3) << endl;
+    // ----------------------------------------------------
+    // Same as KDTree::kNNValue, over the points of all levels.
+    ElemType kNNValue(const Point<N>& key, size_t k) const;
+
+private:
+    typedef KDTree<N, ElemType> Tree;
+    typedef typename Tree::Node TreeNode;
+
+    size_t bufferSize_;
+    size_t size_;
+    Tree buffer_;            // Takes new points with pointer inserts
+    vector<Tree*> levels_;   // levels_[i] is NULL or holds bufferSize_ * 2^i points
+
+    // A helper function to find the tree holding the point
+    TreeNode* findNode(const Point<N>& pt) const;
+
+    // A helper function to push the full buffer down into the levels
+    void carry();
+};
+
+/** LogKDTree class implementation details */
+
+// Construct function
+template <size_t N, typename ElemType>
+LogKDTree<N, ElemType>::LogKDTree(size_t bufferSize) {
+    bufferSize_ = max<size_t>(bufferSize, 1);
+    size_ = 0;
+}
+
+// Destructor function
+template <size_t N, typename ElemType>
+LogKDTree<N, ElemType>::~LogKDTree() {
+    for (size_t i = 0; i < levels_.size(); ++i)
+        delete levels_[i];
+}
+
+template <size_t N, typename ElemType>
+inline size_t LogKDTree<N, ElemType>::dimension() const {
+    return N;
+}
+
+template <size_t N, typename ElemType>
+inline size_t LogKDTree<N, ElemType>::size() const {
+    return size_;
+}
+
+template <size_t N, typename ElemType>
+inline bool LogKDTree<N, ElemType>::empty() const {
+    return size() == 0;
+}
+
+template <size_t N, typename ElemType>
+size_t LogKDTree<N, ElemType>::numLevels() const {
+    size_t count = 0;
+    for (size_t i = 0; i < levels_.size(); ++i)
+        count += levels_[i] != NULL;
+    return count;
+}
+
+// A helper function to find the node which has the Point pt in any tree
+template <size_t N, typename ElemType>
+typename LogKDTree<N, ElemType>::TreeNode* LogKDTree<N, ElemType>::findNode(const Point<N> &pt) const {
+    TreeNode *found_node = buffer_.findNode(pt);
+    for (size_t i = 0; found_node == NULL && i < levels_.size(); ++i) {
+        if (levels_[i] != NULL)
+            found_node = levels_[i]->findNode(pt);
+    }
+    return found_node;
+}
+
+template <size_t N, typename ElemType>
+bool LogKDTree<N, ElemType>::contains(const Point<N> &pt) const {
+    return findNode(pt) != NULL;
+}
+
+template <size_t N, typename ElemType>
+const ElemType &LogKDTree<N, ElemType>::at(const Point<N> &pt) const {
+    TreeNode *found_node = findNode(pt);
+
+    if (found_node != NULL) {
+        return found_node->value_;
+    }
+    else
+        throw out_of_range("This point doesn't exist!");
+}
+
+// Insert overwrites a point already present in place, so that every point
+// lives in exactly one tree
+template <size_t N, typename ElemType>
+void LogKDTree<N, ElemType>::insert(const Point<N> &pt, const ElemType &value) {
+    TreeNode *found_node = findNode(pt);
+    if (found_node != NULL) {
+        found_node->value_ = value;
+        return;
+    }
+
+    buffer_.insert(pt, value);
+    ++size_;
+    if (buffer_.size() >= bufferSize_)
+        carry();
+}
+
+// carry collects the buffer and the full levels below the first empty one and
+// bulk-builds them into that level
+template <size_t N, typename ElemType>
+void LogKDTree<N, ElemType>::carry() {
+    size_t target = 0;
+    while (target < levels_.size() && levels_[target] != NULL)
+        ++target;
+    if (target == levels_.size())
+        levels_.push_back(NULL);
+
+    vector< pair<Point<N>, ElemType> > entries;
+    entries.reserve(bufferSize_ << target);
+    for (size_t i = 0; i < buffer_.nodes_.size(); ++i)
+        entries.push_back(make_pair(buffer_.nodes_[i]->pt_, buffer_.nodes_[i]->value_));
+    for (size_t level = 0; level < target; ++level) {
+        const vector<TreeNode*>& nodes = levels_[level]->nodes_;
+        for (size_t i = 0; i < nodes.size(); ++i)
+            entries.push_back(make_pair(nodes[i]->pt_, nodes[i]->value_));
+        delete levels_[level];
+        levels_[level] = NULL;
+    }
+
+    levels_[target] = new Tree(entries.begin(), entries.end());
+    buffer_ = Tree();
+}
+
+// kNNValue function, the largest levels are searched first since they are
+// most likely to hold the neighbors, which tightens the shared bound early
+template <size_t N, typename ElemType>
+ElemType LogKDTree<N, ElemType>::kNNValue(const Point<N> &key, size_t k) const {
+    BoundedPQueue<TreeNode*> bpq(k);
+    vector<const TreeNode*> nearest;
+    vector<const Tree*> trees(levels_.rbegin(), levels_.rend());
+    trees.push_back(&buffer_);
+    for (size_t i = 0; i < trees.size(); ++i) {
+        const Tree *tree = trees[i];
+        if (tree == NULL)
+            continue;
+
+        if (tree->preferLinearScan()) {
+            nearest.clear();
+            tree->kNNScan(key, k, nearest);
+            for (size_t j = 0; j < nearest.size(); ++j)
+                bpq.enqueue(const_cast<TreeNode*>(nearest[j]), Distance(nearest[j]->pt_, key));
+        }
+        else {
+            tree->kNNValueRe(key, bpq, tree->root_);
+        }
+    }
+
+    vector<ElemType> kValues;
+    while (!bpq.empty())
+        kValues.push_back(bpq.dequeueMin()->value_);
+
+    return Tree::majorityValue(kValues);
+}
+
+#endif // LOG_KDTREE_INCLUDED
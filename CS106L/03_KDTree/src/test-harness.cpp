@@ -19,6 +19,11 @@
 #include <cstdarg>
 #include <set>
 #include "KDTree.h"
+#include "KDForest.h"
+#include "LogKDTree.h"
+#include "CompressedKDTree.h"
+#include <cstdio>
+#include <fstream>
 using namespace std;
 
 /* These flags control which tests will be run.  Initially, only the
@@ -36,6 +41,11 @@ using namespace std;
 
 #define NearestNeighborTestEnabled      1 // Step two checks
 #define MoreNearestNeighborTestEnabled  1
+#define HighDimensionalNearestNeighborTestEnabled 1
+#define BulkConstructionTestEnabled     1
+#define ForestTestEnabled               1
+#define LogKDTreeTestEnabled            1
+#define CompressedKDTreeTestEnabled     1
 
 #define BasicCopyTestEnabled            1 // Step three checks
 #define ModerateCopyTestEnabled         1
@@ -626,6 +636,257 @@ void MoreNearestNeighborTest() try {
   FailTest(e);
 }
 
+/* This test checks 1-NN lookups on 32-dimensional data, where the tree is too
+ * small to prune and queries are answered by the linear scan.  The answers are
+ * compared against a naive search over the same points.
+ */
+void HighDimensionalNearestNeighborTest() try {
+#if HighDimensionalNearestNeighborTestEnabled
+  PrintBanner("High-Dimensional Nearest Neighbor Test");
+
+  /* Fill the tree with pseudo-random points from a fixed-seed generator. */
+  const size_t kNumPoints = 1000;
+  unsigned seed = 137;
+  vector< Point<32> > points(kNumPoints);
+  KDTree<32, size_t> kd;
+  for (size_t i = 0; i < kNumPoints; ++i) {
+    for (size_t j = 0; j < 32; ++j) {
+      seed = seed * 1103515245u + 12345u;
+      points[i][j] = (seed >> 16) % 1000 / 100.0;
+    }
+    kd.insert(points[i], i);
+  }
+
+  /* Every point in the tree is its own nearest neighbor. */
+  bool allFound = true;
+  for (size_t i = 0; i < kNumPoints; ++i)
+    allFound &= (kd.kNNValue(points[i], 1) == i);
+  CheckCondition(allFound, "Nearest neighbor of element is that element.");
+
+  /* Perturbed queries agree with a naive search. */
+  bool allMatch = true;
+  for (size_t i = 0; i < kNumPoints; i += 7) {
+    Point<32> query = points[i];
+    for (size_t j = 0; j < 32; j += 3)
+      query[j] += 0.5;
+
+    size_t best = 0;
+    for (size_t j = 1; j < kNumPoints; ++j)
+      if (Distance(points[j], query) < Distance(points[best], query))
+        best = j;
+    allMatch &= (kd.kNNValue(query, 1) == best);
+  }
+  CheckCondition(allMatch, "Test points yielded correct nearest neighbors.");
+
+  /* A copy must answer queries the same way as the original. */
+  KDTree<32, size_t> copy = kd;
+  CheckCondition(copy.kNNValue(points[42], 1) == 42, "Copied tree answers high-dimensional queries.");
+
+  /* One scratch reused across queries and values of k must not change the answers. */
+  KDTree<32, size_t>::QueryScratch scratch;
+  bool allSame = true;
+  for (size_t i = 0; i < kNumPoints; i += 13) {
+    size_t k = 1 + i % 9;
+    allSame &= (kd.kNNValue(points[i], k, scratch) == kd.kNNValue(points[i], k));
+  }
+  CheckCondition(allSame, "Queries with a reused scratch match plain queries.");
+
+  EndTest();
+#else
+  TestDisabled("HighDimensionalNearestNeighborTest");
+#endif
+} catch (const exception& e) {
+  FailTest(e);
+}
+
+/* This test checks that a tree built in bulk from a range of (point, value)
+ * pairs holds the same contents and answers the same queries as a tree built
+ * with repeated calls to insert.
+ */
+void BulkConstructionTest() try {
+#if BulkConstructionTestEnabled
+  PrintBanner("Bulk Construction Test");
+
+  /* A grid of points with many repeated coordinates, plus a duplicate of the
+   * first point whose value should win.
+   */
+  vector< pair<Point<2>, size_t> > values;
+  for (size_t i = 0; i < 20; ++i)
+    for (size_t j = 0; j < 20; ++j)
+      values.push_back(make_pair(MakePoint(i % 5, j), 20 * i + j));
+  values.push_back(make_pair(MakePoint(0, 0), 1000));
+
+  KDTree<2, size_t> bulk(values.begin(), values.end());
+  KDTree<2, size_t> incremental;
+  for (size_t i = 0; i < values.size(); ++i)
+    incremental.insert(values[i].first, values[i].second);
+
+  CheckCondition(bulk.size() == incremental.size(), "Bulk tree has the right size.");
+  CheckCondition(bulk.at(MakePoint(0, 0)) == 1000, "Last duplicate value wins.");
+
+  bool allFound = true;
+  for (size_t i = 0; i < values.size(); ++i)
+    allFound &= bulk.contains(values[i].first) && bulk.at(values[i].first) == incremental.at(values[i].first);
+  CheckCondition(allFound, "Bulk tree contains every point with the right value.");
+
+  bool allMatch = true;
+  for (double x = -1; x < 6; x += 0.37)
+    for (double y = -1; y < 21; y += 0.53)
+      allMatch &= bulk.kNNValue(MakePoint(x, y), 1) == incremental.kNNValue(MakePoint(x, y), 1);
+  CheckCondition(allMatch, "Bulk tree answers nearest neighbor queries like an incremental one.");
+
+  /* Inserting into a bulk-built tree must keep working. */
+  bulk.insert(MakePoint(2.5, 2.5), 2000);
+  CheckCondition(bulk.contains(MakePoint(2.5, 2.5)) && bulk.kNNValue(MakePoint(2.5, 2.5), 1) == 2000,
+                 "Insert into a bulk-built tree works.");
+
+  EndTest();
+#else
+  TestDisabled("BulkConstructionTest");
+#endif
+} catch (const exception& e) {
+  FailTest(e);
+}
+
+/* This test checks the randomized kd-forest.  With a check budget as large as
+ * the data set the search is exact, so it must agree with the KDTree; with a
+ * small budget it must still find points that are in the forest.
+ */
+void ForestTest() try {
+#if ForestTestEnabled
+  PrintBanner("Forest Test");
+
+  const size_t kNumPoints = 2000;
+  unsigned seed = 271;
+  vector< pair<Point<16>, size_t> > values;
+  for (size_t i = 0; i < kNumPoints; ++i) {
+    Point<16> pt;
+    for (size_t j = 0; j < 16; ++j) {
+      seed = seed * 1103515245u + 12345u;
+      pt[j] = (seed >> 16) % 1000 / 100.0;
+    }
+    values.push_back(make_pair(pt, i));
+  }
+
+  KDForest<16, size_t> forest(values.begin(), values.end(), 4);
+  KDTree<16, size_t> kd(values.begin(), values.end());
+  CheckCondition(forest.size() == kNumPoints && forest.numTrees() == 4, "Forest has the right size.");
+
+  bool allExact = true;
+  for (size_t i = 0; i < kNumPoints; i += 13) {
+    Point<16> query = values[i].first;
+    query[i % 16] += 1.5;
+    allExact &= forest.kNNValue(query, 1, kNumPoints) == kd.kNNValue(query, 1);
+  }
+  CheckCondition(allExact, "Unbounded forest search agrees with the tree.");
+
+  bool allFound = true;
+  for (size_t i = 0; i < kNumPoints; i += 13)
+    allFound &= forest.kNNValue(values[i].first, 1, 32) == i;
+  CheckCondition(allFound, "Bounded forest search finds points in the forest.");
+
+  EndTest();
+#else
+  TestDisabled("ForestTest");
+#endif
+} catch (const exception& e) {
+  FailTest(e);
+}
+
+/* This test checks the logarithmic-method container against a plain KDTree
+ * fed with the same inserts, including points inserted twice.
+ */
+void LogKDTreeTest() try {
+#if LogKDTreeTestEnabled
+  PrintBanner("LogKDTree Test");
+
+  LogKDTree<2, size_t> log(16);
+  KDTree<2, size_t> kd;
+  unsigned seed = 314;
+  for (size_t i = 0; i < 1000; ++i) {
+    seed = seed * 1103515245u + 12345u;
+    double x = (seed >> 16) % 100;
+    seed = seed * 1103515245u + 12345u;
+    double y = (seed >> 16) % 100;
+    log.insert(MakePoint(x, y), i);
+    kd.insert(MakePoint(x, y), i);
+  }
+
+  CheckCondition(log.size() == kd.size(), "LogKDTree has the right size.");
+  CheckCondition(log.numLevels() > 1, "LogKDTree spread points over several levels.");
+
+  bool allFound = true;
+  for (double x = 0; x < 100; x += 3)
+    for (double y = 0; y < 100; y += 3)
+      allFound &= log.contains(MakePoint(x, y)) == kd.contains(MakePoint(x, y)) &&
+                  (!kd.contains(MakePoint(x, y)) || log.at(MakePoint(x, y)) == kd.at(MakePoint(x, y)));
+  CheckCondition(allFound, "LogKDTree holds the latest value of every point.");
+
+  bool allMatch = true;
+  for (double x = -5; x < 105; x += 2.71)
+    for (double y = -5; y < 105; y += 3.14)
+      allMatch &= log.kNNValue(MakePoint(x, y), 1) == kd.kNNValue(MakePoint(x, y), 1);
+  CheckCondition(allMatch, "LogKDTree answers nearest neighbor queries like a KDTree.");
+
+  EndTest();
+#else
+  TestDisabled("LogKDTreeTest");
+#endif
+} catch (const exception& e) {
+  FailTest(e);
+}
+
+/* This test writes a compressed snapshot of a tree, reopens it and checks that
+ * it is smaller than the raw coordinates and answers the same queries.
+ */
+void CompressedKDTreeTest() try {
+#if CompressedKDTreeTestEnabled
+  PrintBanner("Compressed KDTree Test");
+
+  const size_t kNumPoints = 20000;
+  const char* kSnapshotFile = "kdtree-snapshot.tmp";
+  unsigned seed = 161;
+  vector< pair<Point<3>, int> > values;
+  for (size_t i = 0; i < kNumPoints; ++i) {
+    Point<3> pt;
+    for (size_t j = 0; j < 3; ++j) {
+      seed = seed * 1103515245u + 12345u;
+      pt[j] = (seed >> 8) % 1000000 / 1000.0;
+    }
+    values.push_back(make_pair(pt, int(i)));
+  }
+  KDTree<3, int> kd(values.begin(), values.end());
+  CompressedKDTree<3, int>::save(kd, kSnapshotFile, 16, 1024);
+
+  ifstream file(kSnapshotFile, ios::binary | ios::ate);
+  size_t fileSize = file.tellg();
+  CheckCondition(fileSize < kNumPoints * 3 * sizeof(double), "Snapshot is smaller than the raw coordinates.");
+
+  CompressedKDTree<3, int> snapshot(kSnapshotFile);
+  CheckCondition(snapshot.size() == kd.size(), "Snapshot has the right size.");
+  CheckCondition(snapshot.blocksLoaded() == 0, "Opening a snapshot loads no blocks.");
+
+  bool allFound = true;
+  for (size_t i = 0; i < kNumPoints; i += 97)
+    allFound &= snapshot.kNNValue(values[i].first, 1) == values[i].second;
+  CheckCondition(allFound, "Snapshot finds the points it was built from.");
+
+  CompressedKDTree<3, int> cold(kSnapshotFile);
+  cold.kNNValue(values[0].first, 1);
+  CheckCondition(cold.blocksLoaded() < 4, "A single query loads only a few blocks.");
+
+  KDTree<3, int> restored = snapshot.decompress();
+  CheckCondition(restored.size() == kd.size(), "Decompressed tree has the right size.");
+
+  remove(kSnapshotFile);
+  EndTest();
+#else
+  TestDisabled("CompressedKDTreeTest");
+#endif
+} catch (const exception& e) {
+  FailTest(e);
+}
+
 /* Tests basic behavior of the copy constructor and assignment operator. */
 void BasicCopyTest() try {
 #if BasicCopyTestEnabled
@@ -755,6 +1016,11 @@ int main() {
   /* Step Three Tests */
   NearestNeighborTest();
   MoreNearestNeighborTest();
+  HighDimensionalNearestNeighborTest();
+  BulkConstructionTest();
+  ForestTest();
+  LogKDTreeTest();
+  CompressedKDTreeTest();
 
   /* Step Four Tests */
   BasicCopyTest();
@@ -769,6 +1035,11 @@ int main() {
      ConstKDTreeTestEnabled && \
      NearestNeighborTestEnabled &&  \
      MoreNearestNeighborTestEnabled && \
+     HighDimensionalNearestNeighborTestEnabled && \
+     BulkConstructionTestEnabled && \
+     ForestTestEnabled && \
+     LogKDTreeTestEnabled && \
+     CompressedKDTreeTestEnabled && \
      BasicCopyTestEnabled && \
      ModerateCopyTestEnabled)
   cout << "All tests completed!  If they passed, you should be good to go!" << endl << endl;
@@ -0,0 +1,118 @@
+/**
+ * File: kd-forest-bench.cpp
+ * Author: Zach Gu
+ * ------------------------
+ * Measures the recall/latency trade-off of KDForest against the exact
+ * KDTree::kNNValue on clustered 32-, 64- and 128-dimensional data with a
+ * low intrinsic dimension.
+ *
+ * Every point is labelled with its own index, so a 1-NN query returns the
+ * identity of the neighbor it found and recall is the fraction of queries on
+ * which the forest returns the same point as the exact search.
+ *
+ * Usage: kd-forest-bench [points] [queries] [trees]
+ *
+ * Prints one CSV line per (dimension, check budget):
+ *   dim,checks,recall,forest_us_per_query,exact_us_per_query
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "KDForest.h"
+
+using namespace std;
+
+const size_t kNumClusters = 64;
+const size_t kLatentDim = 8;
+const size_t kBudgets[] = {16, 32, 64, 128, 256, 512, 1024, 2048, 4096};
+
+// Draws points around random cluster centers in a kLatentDim-dimensional
+// space and embeds them into N dimensions with a fixed random linear map plus
+// a little noise. Real embeddings look like this: high ambient dimension but
+// a much lower intrinsic one.
+template <size_t N>
+vector< Point<N> > MakeEmbeddedPoints(size_t count, mt19937& rng) {
+    mt19937 layout(N);
+    uniform_real_distribution<double> uniform(-10.0, 10.0);
+    double centers[kNumClusters][kLatentDim];
+    double embedding[kLatentDim][N];
+    for (size_t c = 0; c < kNumClusters; ++c)
+        for (size_t j = 0; j < kLatentDim; ++j)
+            centers[c][j] = uniform(layout);
+    for (size_t j = 0; j < kLatentDim; ++j)
+        for (size_t i = 0; i < N; ++i)
+            embedding[j][i] = uniform(layout) / 10.0;
+
+    normal_distribution<double> spread(0.0, 1.0), noise(0.0, 0.05);
+    vector< Point<N> > points(count);
+    for (size_t p = 0; p < count; ++p) {
+        double latent[kLatentDim];
+        size_t c = rng() % kNumClusters;
+        for (size_t j = 0; j < kLatentDim; ++j)
+            latent[j] = centers[c][j] + spread(rng);
+        for (size_t i = 0; i < N; ++i) {
+            points[p][i] = noise(rng);
+            for (size_t j = 0; j < kLatentDim; ++j)
+                points[p][i] += latent[j] * embedding[j][i];
+        }
+    }
+    return points;
+}
+
+// Microseconds per call of query(i) over all i < count
+template <typename Query>
+double MicrosPerQuery(size_t count, Query query) {
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i)
+        query(i);
+    chrono::duration<double, micro> elapsed = chrono::steady_clock::now() - start;
+    return elapsed.count() / count;
+}
+
+template <size_t N>
+void RunBenchmark(size_t numPoints, size_t numQueries, size_t numTrees) {
+    mt19937 rng(N);
+    vector< Point<N> > points = MakeEmbeddedPoints<N>(numPoints, rng);
+    vector< Point<N> > queries = MakeEmbeddedPoints<N>(numQueries, rng);
+
+    vector< pair<Point<N>, size_t> > values;
+    for (size_t i = 0; i < points.size(); ++i)
+        values.push_back(make_pair(points[i], i));
+
+    KDTree<N, size_t> tree(values.begin(), values.end());
+    KDForest<N, size_t> forest(values.begin(), values.end(), numTrees);
+
+    vector<size_t> exact(numQueries);
+    double exactTime = MicrosPerQuery(numQueries, [&](size_t i) {
+        exact[i] = tree.kNNValue(queries[i], 1);
+    });
+
+    for (size_t b = 0; b < sizeof(kBudgets) / sizeof(kBudgets[0]); ++b) {
+        size_t hits = 0;
+        double forestTime = MicrosPerQuery(numQueries, [&](size_t i) {
+            hits += forest.kNNValue(queries[i], 1, kBudgets[b]) == exact[i];
+        });
+        cout << N << "," << kBudgets[b] << "," << double(hits) / numQueries << ","
+             << forestTime << "," << exactTime << endl;
+    }
+}
+
+int main(int argc, char **argv) {
+    size_t numPoints = argc > 1 ? strtoul(argv[1], NULL, 10) : 50000;
+    size_t numQueries = argc > 2 ? strtoul(argv[2], NULL, 10) : 500;
+    size_t numTrees = argc > 3 ? strtoul(argv[3], NULL, 10) : 8;
+    if (numPoints == 0 || numQueries == 0) {
+        cerr << "Usage: " << argv[0] << " [points] [queries] [trees]" << endl;
+        return 1;
+    }
+
+    cout << "dim,checks,recall,forest_us_per_query,exact_us_per_query" << endl;
+    RunBenchmark<32>(numPoints, numQueries, numTrees);
+    RunBenchmark<64>(numPoints, numQueries, numTrees);
+    RunBenchmark<128>(numPoints, numQueries, numTrees);
+    return 0;
+}
@@ -0,0 +1,327 @@
+/**
+ * File: knn-classify.cpp
+ * Author: Zach Gu
+ * ------------------------
+ * A batch k-nearest-neighbor classifier built on KDTree. It reads labelled
+ * training points, bulk-builds a tree from them, and then streams query
+ * points through three overlapped stages:
+ *
+ *   reader  ->  query workers  ->  writer
+ *
+ * The stages exchange a fixed pool of batches, so memory stays bounded no
+ * matter how many queries there are, and the batches are recycled instead of
+ * being allocated per query.
+ *
+ * Usage: knn-classify <dim> <k> <train-file> <query-file> <output-file> [threads]
+ *
+ * Input files are either CSV or binary, detected from their first bytes.
+ *   CSV:    one point per line, "x1,x2,...,xN" with an extra integer label
+ *           column for training points.
+ *   Binary: the magic "KNNP", uint32 dimension, uint32 hasLabels, uint64
+ *           count, followed by count records of N doubles and, if hasLabels
+ *           is set, an int32 label.
+ * The output file holds one label per line, in query order.
+ */
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "KDTree.h"
+
+using namespace std;
+
+const size_t kBatchSize = 4096;     // Query points per batch
+const size_t kBatchesInFlight = 8;  // Batches shared by the three stages
+const char kBinaryMagic[4] = {'K', 'N', 'N', 'P'};
+
+// A FILE* that is closed when it goes out of scope, thrown past or not
+typedef unique_ptr<FILE, int (*)(FILE*)> FilePtr;
+
+/* A thread-safe FIFO queue. pop() blocks until an element is available or the
+ * queue is closed and drained, in which case it returns false.
+ */
+template <typename T>
+class BlockingQueue {
+public:
+    BlockingQueue() : closed_(false) {}
+
+    void push(const T& value) {
+        {
+            lock_guard<mutex> lock(mutex_);
+            elems_.push_back(value);
+        }
+        ready_.notify_one();
+    }
+
+    bool pop(T& value) {
+        unique_lock<mutex> lock(mutex_);
+        while (elems_.empty() && !closed_)
+            ready_.wait(lock);
+        if (elems_.empty())
+            return false;
+
+        value = elems_.front();
+        elems_.pop_front();
+        return true;
+    }
+
+    void close() {
+        {
+            lock_guard<mutex> lock(mutex_);
+            closed_ = true;
+        }
+        ready_.notify_all();
+    }
+
+private:
+    deque<T> elems_;
+    mutex mutex_;
+    condition_variable ready_;
+    bool closed_;
+};
+
+/* Reads points from a CSV or binary file, a record at a time. */
+template <size_t N>
+class PointReader {
+public:
+    PointReader(const string& path, bool hasLabels)
+        : file_(fopen(path.c_str(), "rb"), fclose), hasLabels_(hasLabels), binary_(false) {
+        if (file_ == NULL)
+            throw runtime_error("Cannot open " + path);
+        setvbuf(file_.get(), NULL, _IOFBF, 1 << 20);
+
+        char magic[4];
+        if (fread(magic, 1, 4, file_.get()) == 4 && memcmp(magic, kBinaryMagic, 4) == 0) {
+            uint32_t dim, labelled;
+            uint64_t count;
+            if (fread(&dim, sizeof(dim), 1, file_.get()) != 1 ||
+                fread(&labelled, sizeof(labelled), 1, file_.get()) != 1 ||
+                fread(&count, sizeof(count), 1, file_.get()) != 1)
+                throw runtime_error("Truncated header in " + path);
+            if (dim != N)
+                throw runtime_error("Dimension mismatch in " + path);
+            if ((labelled != 0) != hasLabels)
+                throw runtime_error("Unexpected label column in " + path);
+            binary_ = true;
+        }
+        else {
+            rewind(file_.get());
+        }
+    }
+
+    // Reads the next record, returns false at the end of the file
+    bool read(Point<N>& pt, int& label) {
+        return binary_ ? readBinary(pt, label) : readText(pt, label);
+    }
+
+private:
+    bool readBinary(Point<N>& pt, int& label) {
+        if (fread(pt.begin(), sizeof(double), N, file_.get()) != N)
+            return false;
+
+        int32_t value = 0;
+        if (hasLabels_ && fread(&value, sizeof(value), 1, file_.get()) != 1)
+            throw runtime_error("Truncated record");
+        label = value;
+        return true;
+    }
+
+    bool readText(Point<N>& pt, int& label) {
+        // Skip blank lines
+        do {
+            if (fgets(line_, sizeof(line_), file_.get()) == NULL)
+                return false;
+        } while (line_[strspn(line_, " \t\r\n")] == '\0');
+
+        char *cursor = line_;
+        for (size_t i = 0; i < N; ++i) {
+            char *next;
+            pt[i] = strtod(cursor, &next);
+            if (next == cursor)
+                throw runtime_error(string("Malformed line: ") + line_);
+            cursor = next + strspn(next, " \t,");
+        }
+        if (hasLabels_)
+            label = static_cast<int>(strtol(cursor, NULL, 10));
+        return true;
+    }
+
+    FilePtr file_;
+    bool hasLabels_;
+    bool binary_;
+    char line_[1 << 16];
+};
+
+/* A batch of query points and their labels, tagged with its position in the
+ * query stream so that the writer can restore the input order.
+ */
+template <size_t N>
+struct Batch {
+    size_t id;
+    size_t count;
+    vector< Point<N> > points;
+    vector<int> labels;
+};
+
+// Run the pipeline for points of dimension N
+template <size_t N>
+void Classify(size_t k, const string& trainPath, const string& queryPath,
+              const string& outputPath, size_t numThreads) {
+    // Load and bulk-build the training tree
+    vector< pair<Point<N>, int> > training;
+    {
+        PointReader<N> reader(trainPath, true);
+        Point<N> pt;
+        int label;
+        while (reader.read(pt, label))
+            training.push_back(make_pair(pt, label));
+    }
+    const KDTree<N, int> tree(training.begin(), training.end());
+    vector< pair<Point<N>, int> >().swap(training);
+    cerr << "Built tree with " << tree.size() << " points" << endl;
+
+    FilePtr output(fopen(outputPath.c_str(), "wb"), fclose);
+    if (output == NULL)
+        throw runtime_error("Cannot open " + outputPath);
+    setvbuf(output.get(), NULL, _IOFBF, 1 << 20);
+
+    // The batch pool bounds the memory used by the pipeline
+    vector< Batch<N> > pool(kBatchesInFlight);
+    BlockingQueue<Batch<N>*> freeBatches, filled, classified;
+    for (size_t i = 0; i < pool.size(); ++i) {
+        pool[i].points.resize(kBatchSize);
+        pool[i].labels.resize(kBatchSize);
+        freeBatches.push(&pool[i]);
+    }
+
+    // Reader stage
+    string readError;
+    thread readerThread([&]() {
+        try {
+            PointReader<N> reader(queryPath, false);
+            int unused;
+            Batch<N> *batch;
+            for (size_t id = 0; freeBatches.pop(batch); ++id) {
+                batch->id = id;
+                batch->count = 0;
+                while (batch->count < kBatchSize && reader.read(batch->points[batch->count], unused))
+                    ++batch->count;
+                if (batch->count == 0)
+                    break;
+                filled.push(batch);
+                if (batch->count < kBatchSize)
+                    break;
+            }
+        }
+        catch (const exception& e) {
+            readError = e.what();
+        }
+        filled.close();
+    });
+
+    // Query stage, every worker reusing one query scratch for all its points
+    vector<thread> workers;
+    for (size_t t = 0; t < numThreads; ++t) {
+        workers.push_back(thread([&]() {
+            typename KDTree<N, int>::QueryScratch scratch;
+            Batch<N> *batch;
+            while (filled.pop(batch)) {
+                for (size_t i = 0; i < batch->count; ++i)
+                    batch->labels[i] = tree.kNNValue(batch->points[i], k, scratch);
+                classified.push(batch);
+            }
+        }));
+    }
+
+    // Writer stage, runs on this thread and emits batches in input order
+    thread closer([&]() {
+        for (size_t t = 0; t < workers.size(); ++t)
+            workers[t].join();
+        classified.close();
+    });
+
+    map<size_t, Batch<N>*> pending;
+    size_t nextId = 0, written = 0;
+    Batch<N> *batch;
+    while (classified.pop(batch)) {
+        pending[batch->id] = batch;
+        while (!pending.empty() && pending.begin()->first == nextId) {
+            Batch<N> *ready = pending.begin()->second;
+            pending.erase(pending.begin());
+            for (size_t i = 0; i < ready->count; ++i)
+                fprintf(output.get(), "%d\n", ready->labels[i]);
+            written += ready->count;
+            ++nextId;
+            freeBatches.push(ready);
+        }
+    }
+    freeBatches.close();
+
+    readerThread.join();
+    closer.join();
+    output.reset();
+
+    if (!readError.empty())
+        throw runtime_error(readError);
+    cerr << "Classified " << written << " points" << endl;
+}
+
+// Dimensions are template parameters, so every supported one is listed here
+typedef void (*ClassifyFunction)(size_t, const string&, const string&, const string&, size_t);
+
+ClassifyFunction FindClassifier(size_t dim) {
+    switch (dim) {
+    case 1: return Classify<1>;
+    case 2: return Classify<2>;
+    case 3: return Classify<3>;
+    case 4: return Classify<4>;
+    case 8: return Classify<8>;
+    case 16: return Classify<16>;
+    case 32: return Classify<32>;
+    case 64: return Classify<64>;
+    case 128: return Classify<128>;
+    default: return NULL;
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 6) {
+        cerr << "Usage: " << argv[0]
+             << " <dim> <k> <train-file> <query-file> <output-file> [threads]" << endl;
+        return 1;
+    }
+
+    size_t dim = strtoul(argv[1], NULL, 10);
+    size_t k = strtoul(argv[2], NULL, 10);
+    size_t numThreads = argc > 6 ? strtoul(argv[6], NULL, 10) : thread::hardware_concurrency();
+    if (numThreads == 0)
+        numThreads = 1;
+
+    ClassifyFunction classify = FindClassifier(dim);
+    if (classify == NULL || k == 0) {
+        cerr << "Unsupported dimension " << dim << " or k " << k << endl;
+        return 1;
+    }
+
+    try {
+        classify(k, argv[3], argv[4], argv[5], numThreads);
+    }
+    catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}